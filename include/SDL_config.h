@@ -135,6 +135,8 @@
 #define HAVE_SA_SIGACTION 1
 #define HAVE_SETJMP 1
 #define HAVE_NANOSLEEP 1
+#define HAVE_SYSCONF 1
+#define HAVE_GETAUXVAL 1
 /* #undef HAVE_CLOCK_GETTIME */
 #define HAVE_GETPAGESIZE 1
 #define HAVE_MPROTECT 1
@@ -60,6 +60,24 @@ extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE2(void);
 /** This function returns true if the CPU has AltiVec features */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasAltiVec(void);
 
+/** This function returns true if the CPU has VFP floating point */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasVFP(void);
+
+/** This function returns true if the CPU has ARM NEON (AdvSIMD) features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasNEON(void);
+
+/** This function returns true if the CPU is ARMv8, in either 32 or 64-bit mode */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasARMv8(void);
+
+/** This function returns the number of CPU cores online, at least 1 */
+extern DECLSPEC int SDLCALL SDL_GetCPUCount(void);
+
+/**
+ *  This function returns the L1 data cache line size in bytes, or a
+ *  sensible guess for the CPU family when the system can't tell.
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCacheLineSize(void);
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
@@ -242,6 +242,18 @@ typedef union SDL_Event {
 } SDL_Event;
 
 
+/** Event queue statistics, see SDL_GetEventQueueStats() */
+typedef struct SDL_EventQueueStats {
+	Uint32 queued;		/**< Events waiting to be read */
+	Uint32 capacity;	/**< Events the queue holds before it has to grow */
+	Uint32 limit;		/**< Events the queue may grow to */
+	Uint32 peak;		/**< Most events ever waiting at once */
+	Uint32 coalesced;	/**< Motion events merged into queued ones */
+	Uint32 dropped;		/**< Events lost because the queue was full */
+	Uint32 dropped_type[SDL_NUMEVENTS];	/**< Events lost, by type */
+} SDL_EventQueueStats;
+
+
 /* Function prototypes */
 
 /** Pumps the event loop, gathering events from the input devices.
@@ -283,18 +295,60 @@ extern DECLSPEC int SDLCALL SDL_PeepEvents(SDL_Event *events, int numevents,
  */
 extern DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event *event);
 
+/** Pumps the event loop once, then removes up to 'numevents' pending events
+ *  matching 'mask' from the queue and stores them in 'events', oldest
+ *  first.  Events that don't match stay queued in order.  Meant for main
+ *  loops that handle everything that piled up during a frame at once.
+ *
+ *  @return The number of events stored, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_PollEvents(SDL_Event *events, int numevents,
+				Uint32 mask);
+
 /** Waits indefinitely for the next available event, returning 1, or 0 if there
  *  was an error while waiting for events.  If 'event' is not NULL, the next
  *  event is removed from the queue and stored in that area.
  */
 extern DECLSPEC int SDLCALL SDL_WaitEvent(SDL_Event *event);
 
+/** Waits until the specified timeout (in milliseconds) for the next
+ *  available event, returning 1, or 0 if there was an error or the timeout
+ *  expired.  A timeout of -1 waits indefinitely.  If 'event' is not NULL,
+ *  the next event is removed from the queue and stored in that area.
+ */
+extern DECLSPEC int SDLCALL SDL_WaitEventTimeout(SDL_Event *event, int timeout);
+
+/** Returns when an event really happened, in microseconds, on the same
+ *  monotonic clock as SDL_FrameStats.flip_time, so input to display
+ *  latency is the difference of the two.  Drivers that read evdev devices
+ *  use the kernel's timestamp, others the time the event was queued.
+ *  'event' must be one of the last 64 events taken off the queue, or one
+ *  still queued; 0 is returned for anything else.  The clock wraps, only
+ *  use differences.
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_GetEventTimestamp(const SDL_Event *event);
+
 /** Add an event to the event queue.
  *  This function returns 0 on success, or -1 if the event queue was full
  *  or there was some other error.
  */
 extern DECLSPEC int SDLCALL SDL_PushEvent(SDL_Event *event);
 
+/**
+ *  Fills in 'stats' with the state of the event queue and the events lost
+ *  since the event loop was started.  The queue starts with room for
+ *  SDL_EVENT_QUEUE_SIZE events (128 by default) and grows when it fills
+ *  up, to SDL_EVENT_QUEUE_MAX events (16384 by default); only past that
+ *  are events dropped.
+ *
+ *  With SDL_EVENT_COALESCE=1 mouse motion, joystick axis and trackball
+ *  events are merged into the last one still queued for the same device
+ *  and axis, if only other motion events came after it: the position or
+ *  axis value is the newest one and relative motion is summed.  The
+ *  queue then holds about one motion event per axis between reads.
+ */
+extern DECLSPEC void SDLCALL SDL_GetEventQueueStats(SDL_EventQueueStats *stats);
+
 /** @name Event Filtering */
 /*@{*/
 typedef int (SDLCALL *SDL_EventFilter)(const SDL_Event *event);
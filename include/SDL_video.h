@@ -187,6 +187,20 @@ typedef struct SDL_VideoInfo {
 	int    current_h;	/**< Value: The current video mode height */
 } SDL_VideoInfo;
 
+/** Frame pacing statistics, see SDL_GetFrameStats() */
+typedef struct SDL_FrameStats {
+	Uint32 frames;		/**< Frames that reached the screen */
+	Uint32 sequence;	/**< Vblank counter at the last flip, 0 if unknown */
+	Uint32 missed_vblanks;	/**< Vblanks that showed the previous frame again */
+	Uint32 last_latency;	/**< Hand-over to flip time of the last frame, in us */
+	Uint32 avg_latency;	/**< Average hand-over to flip time, in us */
+	Uint32 max_latency;	/**< Worst hand-over to flip time, in us */
+	Uint32 copy_time;	/**< Total time spent copying pixels, in ms */
+	Uint32 wait_time;	/**< Total time blocked on the display, in ms */
+	Uint32 flip_time;	/**< When the last frame reached the screen, in us,
+				     on the clock of SDL_GetEventTimestamp() */
+} SDL_FrameStats;
+
 
 /** @name Overlay Formats
  *  The most common video overlay formats.
@@ -299,6 +313,26 @@ extern DECLSPEC SDL_Surface * SDLCALL SDL_GetVideoSurface(void);
  */
 extern DECLSPEC const SDL_VideoInfo * SDLCALL SDL_GetVideoInfo(void);
 
+/**
+ * Fills in 'stats' with the frame pacing statistics gathered since the
+ * video driver was initialized.  Missed vblanks are only counted by
+ * drivers that know the vblank sequence number.
+ *
+ * @return 0 on success, or -1 if the video driver doesn't keep statistics.
+ */
+extern DECLSPEC int SDLCALL SDL_GetFrameStats(SDL_FrameStats *stats);
+
+/**
+ * Tells how the video surface is laid out on the display by drivers that
+ * scale it in hardware (see SDL_VIDEO_SCALING).  'src' gets the part of
+ * the surface that is shown and 'dst' where it goes on the display, in
+ * physical pixels; either may be NULL.  Use them to map display
+ * coordinates, like those of a touchscreen, back to the surface.
+ *
+ * @return 0 on success, or -1 if the video driver doesn't scale.
+ */
+extern DECLSPEC int SDLCALL SDL_GetVideoScaling(SDL_Rect *src, SDL_Rect *dst);
+
 /**
  * Check to see if a particular video mode is supported.
  * It returns 0 if the requested mode is not supported under any bit depth,
@@ -737,6 +771,10 @@ extern DECLSPEC SDL_Surface * SDLCALL SDL_ConvertSurface
  * fullscreen application.  The lock will also fail until you have access
  * to the video memory again.
  *
+ * Large software blits can be split into horizontal bands that run on
+ * several threads at once: set SDL_BLIT_THREADS to the number of threads,
+ * counting the caller, or to 0 for one per CPU core.
+ *
  * You should call SDL_BlitSurface() unless you know exactly how SDL
  * blitting works internally and how to use the other blit functions.
  */
@@ -32,6 +32,19 @@
 #include <signal.h>
 #include <setjmp.h>
 #endif
+#if HAVE_SYSCONF
+#include <unistd.h> /* For CPU count and cache line size */
+#elif defined(__WIN32__)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#if HAVE_GETAUXVAL
+#include <sys/auxv.h>
+#endif
+#endif
 
 #define CPU_HAS_RDTSC	0x00000001
 #define CPU_HAS_MMX	0x00000002
@@ -41,6 +54,30 @@
 #define CPU_HAS_SSE	0x00000040
 #define CPU_HAS_SSE2	0x00000080
 #define CPU_HAS_ALTIVEC	0x00000100
+#define CPU_HAS_VFP	0x00000200
+#define CPU_HAS_NEON	0x00000400
+#define CPU_HAS_ARMV8	0x00000800
+
+/* The ARM hwcap bits, from the kernel's asm/hwcap.h */
+#ifndef AT_HWCAP
+#define AT_HWCAP	16
+#endif
+#ifndef AT_HWCAP2
+#define AT_HWCAP2	26
+#endif
+#ifdef __aarch64__
+#define ARM_HWCAP_VFP	(1 << 0)	/* HWCAP_FP */
+#define ARM_HWCAP_NEON	(1 << 1)	/* HWCAP_ASIMD */
+#else
+#define ARM_HWCAP_VFP	(1 << 6)
+#define ARM_HWCAP_NEON	(1 << 12)
+#endif
+
+/* Used when the system can't tell us the cache line size */
+#if defined(__arm__)
+#define CPU_CACHELINE_ARMV6	32
+#endif
+#define CPU_CACHELINE_DEFAULT	64
 
 #if SDL_ALTIVEC_BLITTERS && HAVE_SETJMP && !__MACOSX__
 /* This is the brute force way of detecting instruction sets...
@@ -381,6 +418,101 @@ static __inline__ int CPU_haveAltiVec(void)
 	return altivec; 
 }
 
+#if defined(__linux__) && (defined(__arm__) || defined(__aarch64__))
+/* Reads a small /proc or /sys file into buf, returns the length read */
+static int CPU_readFile(const char *path, char *buf, int len)
+{
+	int fd, amount, total = 0;
+
+	fd = open(path, O_RDONLY);
+	if ( fd < 0 ) {
+		return 0;
+	}
+	while ( total < len-1 &&
+	        (amount = read(fd, buf+total, len-1-total)) > 0 ) {
+		total += amount;
+	}
+	close(fd);
+	buf[total] = '\0';
+	return total;
+}
+
+/* Is word one of the flags on the first "Features" line of /proc/cpuinfo? */
+static int CPU_cpuinfoHas(const char *info, const char *word)
+{
+	const char *flag = SDL_strstr(info, "Features");
+	size_t len = SDL_strlen(word);
+
+	if ( flag ) {
+		flag = SDL_strchr(flag, ':');
+	}
+	while ( flag && *flag && *flag != '\n' ) {
+		while ( *flag == ':' || *flag == ' ' || *flag == '\t' ) {
+			++flag;
+		}
+		if ( SDL_strncmp(flag, word, len) == 0 &&
+		     (flag[len] == ' ' || flag[len] == '\t' ||
+		      flag[len] == '\n' || flag[len] == '\0') ) {
+			return 1;
+		}
+		while ( *flag && *flag != ' ' && *flag != '\t' && *flag != '\n' ) {
+			++flag;
+		}
+	}
+	return 0;
+}
+#endif /* __linux__ && ARM */
+
+static __inline__ int CPU_getARMFeatures(void)
+{
+	int features = 0;
+#if defined(__linux__) && (defined(__arm__) || defined(__aarch64__))
+	unsigned long hwcap = 0;
+	char info[4096];
+
+#if HAVE_GETAUXVAL
+	hwcap = getauxval(AT_HWCAP);
+#endif
+	if ( hwcap ) {
+		if ( hwcap & ARM_HWCAP_VFP ) {
+			features |= CPU_HAS_VFP;
+		}
+		if ( hwcap & ARM_HWCAP_NEON ) {
+			features |= CPU_HAS_NEON;
+		}
+#ifdef __aarch64__
+		features |= CPU_HAS_ARMV8;
+#else
+#if HAVE_GETAUXVAL
+		/* AES, PMULL, SHA1, SHA2 and CRC32 are all ARMv8 only */
+		if ( getauxval(AT_HWCAP2) ) {
+			features |= CPU_HAS_ARMV8;
+		}
+#endif
+#endif
+	} else if ( CPU_readFile("/proc/cpuinfo", info, sizeof(info)) ) {
+		/* 32-bit kernels say vfp and neon, 64-bit ones fp and asimd */
+		if ( CPU_cpuinfoHas(info, "vfp") || CPU_cpuinfoHas(info, "fp") ) {
+			features |= CPU_HAS_VFP;
+		}
+		if ( CPU_cpuinfoHas(info, "neon") || CPU_cpuinfoHas(info, "asimd") ) {
+			features |= CPU_HAS_NEON;
+		}
+		if ( SDL_strstr(info, "CPU architecture: 8") ||
+		     CPU_cpuinfoHas(info, "crc32") || CPU_cpuinfoHas(info, "aes") ) {
+			features |= CPU_HAS_ARMV8;
+		}
+	}
+#elif defined(__aarch64__)
+	/* No way to ask, but ARMv8 always has these */
+	features = CPU_HAS_VFP | CPU_HAS_NEON | CPU_HAS_ARMV8;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	/* No way to ask, trust what the compiler was told */
+	features = CPU_HAS_VFP | CPU_HAS_NEON;
+#endif
+	return features;
+}
+
 static Uint32 SDL_CPUFeatures = 0xFFFFFFFF;
 
 static Uint32 SDL_GetCPUFeatures(void)
@@ -411,10 +543,69 @@ static Uint32 SDL_GetCPUFeatures(void)
 		if ( CPU_haveAltiVec() ) {
 			SDL_CPUFeatures |= CPU_HAS_ALTIVEC;
 		}
+		SDL_CPUFeatures |= CPU_getARMFeatures();
 	}
 	return SDL_CPUFeatures;
 }
 
+static int SDL_CPUCount = 0;
+
+int SDL_GetCPUCount(void)
+{
+	if ( SDL_CPUCount <= 0 ) {
+#if HAVE_SYSCONF && defined(_SC_NPROCESSORS_ONLN)
+		SDL_CPUCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#elif defined(__WIN32__)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		SDL_CPUCount = info.dwNumberOfProcessors;
+#endif
+		if ( SDL_CPUCount <= 0 ) {
+			SDL_CPUCount = 1;
+		}
+	}
+	return SDL_CPUCount;
+}
+
+static int SDL_CPUCacheLineSize = 0;
+
+int SDL_GetCPUCacheLineSize(void)
+{
+	if ( SDL_CPUCacheLineSize <= 0 ) {
+		int size = 0;
+#if HAVE_SYSCONF && defined(_SC_LEVEL1_DCACHE_LINESIZE)
+		/* glibc only knows this on x86 */
+		size = (int)sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#endif
+#if defined(__GNUC__) && defined(__aarch64__)
+		if ( size <= 0 ) {
+			Uint64 ctr;
+			/* DminLine is log2 of the smallest line, in words */
+			__asm__ __volatile__ ("mrs %0, ctr_el0" : "=r" (ctr));
+			size = 4 << ((ctr >> 16) & 0xF);
+		}
+#elif defined(__linux__) && defined(__arm__)
+		if ( size <= 0 ) {
+			char buf[16];
+			if ( CPU_readFile("/sys/devices/system/cpu/cpu0/cache/index0/coherency_line_size", buf, sizeof(buf)) ) {
+				size = SDL_atoi(buf);
+			}
+		}
+#endif
+		if ( size <= 0 ) {
+#ifdef CPU_CACHELINE_ARMV6
+			/* ARM11 has 32 byte lines, the NEON capable cores 64 */
+			if ( !SDL_HasNEON() ) {
+				size = CPU_CACHELINE_ARMV6;
+			} else
+#endif
+			size = CPU_CACHELINE_DEFAULT;
+		}
+		SDL_CPUCacheLineSize = size;
+	}
+	return SDL_CPUCacheLineSize;
+}
+
 SDL_bool SDL_HasRDTSC(void)
 {
 	if ( SDL_GetCPUFeatures() & CPU_HAS_RDTSC ) {
@@ -479,6 +670,30 @@ SDL_bool SDL_HasAltiVec(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasVFP(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_VFP ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasNEON(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_NEON ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasARMv8(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_ARMV8 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
 #ifdef TEST_MAIN
 
 #include <stdio.h>
@@ -493,6 +708,11 @@ int main()
 	printf("SSE: %d\n", SDL_HasSSE());
 	printf("SSE2: %d\n", SDL_HasSSE2());
 	printf("AltiVec: %d\n", SDL_HasAltiVec());
+	printf("VFP: %d\n", SDL_HasVFP());
+	printf("NEON: %d\n", SDL_HasNEON());
+	printf("ARMv8: %d\n", SDL_HasARMv8());
+	printf("CPU count: %d\n", SDL_GetCPUCount());
+	printf("Cache line size: %d\n", SDL_GetCPUCacheLineSize());
 	return 0;
 }
 
@@ -28,25 +28,90 @@
 #include "SDL_sysevents.h"
 #include "SDL_events_c.h"
 #include "../timer/SDL_timer_c.h"
+#include "../video/SDL_framestats_c.h"
 #if !SDL_JOYSTICK_DISABLED
 #include "../joystick/SDL_joystick_c.h"
 #endif
 
+#ifdef __LINUX__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#define SDL_EVENT_FDS	1
+#endif
+
 /* Public data -- the event filter */
 SDL_EventFilter SDL_EventOK = NULL;
 Uint8 SDL_ProcessEvents[SDL_NUMEVENTS];
 static Uint32 SDL_eventstate = 0;
 
-/* Private data -- event queue */
-#define MAXEVENTS	128
+/* The event queue is lock-free for the threads adding events when the
+   compiler has atomic operations.  Otherwise everybody takes the lock.
+ */
+#if !SDL_THREADS_DISABLED && defined(__GNUC__) && \
+    ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+#define SDL_EVENTQ_LOCKFREE	1
+#define SDL_EventQ_CAS(ptr, old, new)	__sync_bool_compare_and_swap(ptr, old, new)
+#define SDL_EventQ_Inc(ptr)		__sync_fetch_and_add(ptr, 1)
+#define SDL_EventQ_Barrier()		__sync_synchronize()
+#else
+#define SDL_EVENTQ_LOCKFREE	0
+#define SDL_EventQ_Inc(ptr)		((*(ptr))++)
+#endif
+
+/* Private data -- event queue.
+   Events are added to 'inbox', a bounded ring any number of threads post
+   to without locking: a cell is claimed by moving 'inbox_tail' on, and
+   published by setting its sequence.  Readers hold the lock, move the
+   published events over to the ordered queue 'event' and peek or cut
+   from there.  That queue grows as needed, up to 'max' events, and only
+   when it can't grow are events dropped.
+ */
+#define MAXEVENTS	128	/* Default size, see SDL_EVENT_QUEUE_SIZE */
+#define MAXQUEUED	16384	/* Default limit, see SDL_EVENT_QUEUE_MAX */
+#define MAXWMMSGS	128
+#define MAXDELIVERED	64	/* Events SDL_GetEventTimestamp() remembers */
+
+typedef struct {
+	volatile Uint32 sequence;
+	Uint32 timestamp;
+	SDL_Event event;
+} SDL_EventCell;
+
 static struct {
 	SDL_mutex *lock;
-	int active;
+	volatile int active;
+
+	/* Where events are posted, lock-free */
+	SDL_EventCell *inbox;
+	Uint32 inbox_mask;
+	volatile Uint32 inbox_tail;	/* Next cell to claim */
+	Uint32 inbox_head;		/* Next cell to read, with the lock */
+
+	/* The ordered queue, with the lock */
+	SDL_Event *event;
+	Uint32 *timestamp;		/* When each event happened */
+	int size;
+	int max;
 	int head;
 	int tail;
-	SDL_Event event[MAXEVENTS];
-	int wmmsg_next;
-	struct SDL_SysWMmsg wmmsg[MAXEVENTS];
+	int peak;
+	int coalesce;			/* Merge motion, see SDL_EVENT_COALESCE */
+	Uint32 coalesced;
+
+	volatile Uint32 dropped[SDL_NUMEVENTS];
+	volatile Uint32 wmmsg_next;
+	struct SDL_SysWMmsg wmmsg[MAXWMMSGS];
+
+	/* A driver's timestamp for the events it's posting */
+	Uint32 post_time;
+	Uint32 post_thread;
+
+	/* The last events taken off the queue, with the lock */
+	SDL_Event delivered[MAXDELIVERED];
+	Uint32 delivered_time[MAXDELIVERED];
+	int delivered_next;
 } SDL_EventQ;
 
 /* Private data -- event locking structure */
@@ -59,6 +124,132 @@ static struct {
 static SDL_Thread *SDL_EventThread = NULL;	/* Thread handle */
 static Uint32 event_thread;			/* The event thread id */
 
+#if SDL_EVENT_FDS
+/* Private data -- the file descriptors events come from.  Waiting for
+   events sleeps on them instead of polling, once the video driver has
+   handed over all of its input sources.
+ */
+static struct {
+	int epoll_fd;
+	int wake_fd;		/* eventfd to interrupt a wait */
+	int num_fds;
+	int num_video_fds;
+} SDL_EventFDs = { -1, -1, 0, 0 };
+
+int SDL_AddEventFD(int fd, int video)
+{
+	struct epoll_event event;
+
+	if ( SDL_EventFDs.epoll_fd < 0 ) {
+		SDL_EventFDs.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		SDL_EventFDs.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if ( SDL_EventFDs.epoll_fd < 0 || SDL_EventFDs.wake_fd < 0 ) {
+			SDL_DelEventFD(-1, 0);
+			return(-1);
+		}
+		SDL_memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.fd = SDL_EventFDs.wake_fd;
+		epoll_ctl(SDL_EventFDs.epoll_fd, EPOLL_CTL_ADD,
+		          SDL_EventFDs.wake_fd, &event);
+	}
+
+	/* The video driver drains its input on every pump.  Anything else
+	   is edge triggered, so a source nobody reads (say, a joystick with
+	   joystick events off) doesn't keep waking us up.
+	 */
+	SDL_memset(&event, 0, sizeof(event));
+	event.events = video ? EPOLLIN : (EPOLLIN | EPOLLET);
+	event.data.fd = fd;
+	if ( epoll_ctl(SDL_EventFDs.epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0 ) {
+		return(-1);
+	}
+	++SDL_EventFDs.num_fds;
+	if ( video ) {
+		++SDL_EventFDs.num_video_fds;
+	}
+	return(0);
+}
+
+void SDL_DelEventFD(int fd, int video)
+{
+	if ( fd >= 0 && SDL_EventFDs.epoll_fd >= 0 &&
+	     epoll_ctl(SDL_EventFDs.epoll_fd, EPOLL_CTL_DEL, fd, NULL) == 0 ) {
+		--SDL_EventFDs.num_fds;
+		if ( video ) {
+			--SDL_EventFDs.num_video_fds;
+		}
+	}
+	if ( SDL_EventFDs.num_fds == 0 ) {
+		if ( SDL_EventFDs.epoll_fd >= 0 ) {
+			close(SDL_EventFDs.epoll_fd);
+		}
+		if ( SDL_EventFDs.wake_fd >= 0 ) {
+			close(SDL_EventFDs.wake_fd);
+		}
+		SDL_EventFDs.epoll_fd = -1;
+		SDL_EventFDs.wake_fd = -1;
+		SDL_EventFDs.num_video_fds = 0;
+	}
+}
+
+/* Interrupts a thread sleeping in SDL_WaitEventFDs().  EAGAIN means the
+   counter is about to overflow, so a wakeup is already pending.
+ */
+static void SDL_WakeEventFDs(void)
+{
+	Uint64 one = 1;
+
+	if ( SDL_EventFDs.wake_fd >= 0 ) {
+		while ( write(SDL_EventFDs.wake_fd, &one, sizeof(one)) < 0 &&
+		        errno == EINTR ) {
+			/* Try again */;
+		}
+	}
+}
+
+/* Sleeps until an event source has input, or for timeout ms (-1 is
+   forever).  Returns 0, or -1 if the sources can't be waited on.
+ */
+static int SDL_WaitEventFDs(int timeout)
+{
+	struct epoll_event events[16];
+	Uint64 count;
+	int repeat;
+
+	if ( SDL_EventFDs.num_video_fds == 0 ) {
+		return(-1);
+	}
+
+	/* Key repeat is the one source without a file descriptor */
+	repeat = SDL_KeyRepeatTimeout();
+	if ( repeat >= 0 && (timeout < 0 || repeat < timeout) ) {
+		timeout = repeat;
+	}
+	if ( epoll_wait(SDL_EventFDs.epoll_fd, events,
+	                SDL_arraysize(events), timeout) > 0 ) {
+		/* Reset the wakeup counter; EAGAIN just means it wasn't set */
+		while ( read(SDL_EventFDs.wake_fd, &count, sizeof(count)) < 0 &&
+		        errno == EINTR ) {
+			/* Try again */;
+		}
+	}
+	return(0);
+}
+#else
+int SDL_AddEventFD(int fd, int video)
+{
+	return(-1);
+}
+
+void SDL_DelEventFD(int fd, int video)
+{
+}
+
+#define SDL_WakeEventFDs()
+#define SDL_WaitEventFDs(timeout)	(-1)
+#endif /* SDL_EVENT_FDS */
+
 void SDL_Lock_EventThread(void)
 {
 	if ( SDL_EventThread && (SDL_ThreadID() != event_thread) ) {
@@ -76,6 +267,95 @@ void SDL_Unlock_EventThread(void)
 	}
 }
 
+/* Round up to a power of two, so the inbox can be indexed with a mask */
+static Uint32 SDL_EventQPower2(int size)
+{
+	Uint32 power = 16;
+
+	while ( power < (Uint32)size && power < 0x10000 ) {
+		power *= 2;
+	}
+	return(power);
+}
+
+/* Allocate the queue, SDL_EVENT_QUEUE_SIZE events to start with.
+   It grows to SDL_EVENT_QUEUE_MAX events before it drops any.
+ */
+static int SDL_InitEventQ(void)
+{
+	const char *env;
+	int size, max;
+	Uint32 i;
+
+	size = MAXEVENTS;
+	env = SDL_getenv("SDL_EVENT_QUEUE_SIZE");
+	if ( env && SDL_atoi(env) > 0 ) {
+		size = SDL_atoi(env);
+	}
+	max = MAXQUEUED;
+	env = SDL_getenv("SDL_EVENT_QUEUE_MAX");
+	if ( env && SDL_atoi(env) > 0 ) {
+		max = SDL_atoi(env);
+	}
+	if ( max < size ) {
+		max = size;
+	}
+	env = SDL_getenv("SDL_EVENT_COALESCE");
+	SDL_EventQ.coalesce = (env && SDL_atoi(env));
+
+	SDL_EventQ.inbox_mask = SDL_EventQPower2(size) - 1;
+	SDL_EventQ.inbox = (SDL_EventCell *)
+		SDL_malloc((SDL_EventQ.inbox_mask+1)*sizeof(*SDL_EventQ.inbox));
+	SDL_EventQ.size = size+1;
+	SDL_EventQ.max = max+1;
+	SDL_EventQ.event = (SDL_Event *)
+		SDL_malloc(SDL_EventQ.size*sizeof(*SDL_EventQ.event));
+	SDL_EventQ.timestamp = (Uint32 *)
+		SDL_malloc(SDL_EventQ.size*sizeof(*SDL_EventQ.timestamp));
+	if ( SDL_EventQ.inbox == NULL || SDL_EventQ.event == NULL ||
+	     SDL_EventQ.timestamp == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	for ( i=0; i<=SDL_EventQ.inbox_mask; ++i ) {
+		SDL_EventQ.inbox[i].sequence = i;
+	}
+	SDL_EventQ.inbox_head = 0;
+	SDL_EventQ.inbox_tail = 0;
+	SDL_EventQ.head = 0;
+	SDL_EventQ.tail = 0;
+	SDL_EventQ.peak = 0;
+	SDL_EventQ.coalesced = 0;
+	SDL_memset((void *)SDL_EventQ.dropped, 0, sizeof(SDL_EventQ.dropped));
+	SDL_EventQ.wmmsg_next = 0;
+	SDL_EventQ.post_time = 0;
+	SDL_memset(SDL_EventQ.delivered, 0, sizeof(SDL_EventQ.delivered));
+	SDL_memset(SDL_EventQ.delivered_time, 0,
+	           sizeof(SDL_EventQ.delivered_time));
+	SDL_EventQ.delivered_next = 0;
+	return(0);
+}
+
+static void SDL_QuitEventQ(void)
+{
+	if ( SDL_EventQ.inbox ) {
+		SDL_free(SDL_EventQ.inbox);
+		SDL_EventQ.inbox = NULL;
+	}
+	if ( SDL_EventQ.event ) {
+		SDL_free(SDL_EventQ.event);
+		SDL_EventQ.event = NULL;
+	}
+	if ( SDL_EventQ.timestamp ) {
+		SDL_free(SDL_EventQ.timestamp);
+		SDL_EventQ.timestamp = NULL;
+	}
+	SDL_EventQ.size = 0;
+	SDL_EventQ.head = 0;
+	SDL_EventQ.tail = 0;
+	SDL_EventQ.wmmsg_next = 0;
+}
+
 #ifdef __OS2__
 /*
  * We'll increase the priority of GobbleEvents thread, so it will process
@@ -122,7 +402,9 @@ static int SDLCALL SDL_GobbleEvents(void *unused)
 		if ( SDL_timer_running ) {
 			SDL_ThreadedTimerCheck();
 		}
-		SDL_Delay(1);
+		if ( SDL_WaitEventFDs(SDL_timer_running ? 1 : -1) < 0 ) {
+			SDL_Delay(1);
+		}
 
 		/* Check for event locking.
 		   On the P of the lock mutex, if the lock is held, this thread
@@ -158,6 +440,9 @@ static int SDL_StartEventThread(Uint32 flags)
 #endif
 	}
 #endif /* !SDL_THREADS_DISABLED */
+	if ( SDL_InitEventQ() < 0 ) {
+		return(-1);
+	}
 	SDL_EventQ.active = 1;
 
 	if ( (flags&SDL_INIT_EVENTTHREAD) == SDL_INIT_EVENTTHREAD ) {
@@ -187,6 +472,7 @@ static int SDL_StartEventThread(Uint32 flags)
 static void SDL_StopEventThread(void)
 {
 	SDL_EventQ.active = 0;
+	SDL_WakeEventFDs();
 	if ( SDL_EventThread ) {
 		SDL_WaitThread(SDL_EventThread, NULL);
 		SDL_EventThread = NULL;
@@ -218,9 +504,7 @@ void SDL_StopEventLoop(void)
 	SDL_QuitQuit();
 
 	/* Clean out EventQ */
-	SDL_EventQ.head = 0;
-	SDL_EventQ.tail = 0;
-	SDL_EventQ.wmmsg_next = 0;
+	SDL_QuitEventQ();
 }
 
 /* This function (and associated calls) may be called more than once */
@@ -261,99 +545,352 @@ int SDL_StartEventLoop(Uint32 flags)
 }
 
 
-/* Add an event to the event queue -- called with the queue locked */
-static int SDL_AddEvent(SDL_Event *event)
+#define SDL_MOTIONMASK	(SDL_MOUSEMOTIONMASK|SDL_JOYAXISMOTIONMASK|\
+			 SDL_JOYBALLMOTIONMASK)
+#define SDL_COALESCE_DEPTH	16	/* Queued motion events looked through */
+
+static Sint16 SDL_AddRel(Sint16 a, Sint16 b)
+{
+	int sum = (int)a + b;
+
+	if ( sum > 32767 ) {
+		sum = 32767;
+	} else if ( sum < -32768 ) {
+		sum = -32768;
+	}
+	return((Sint16)sum);
+}
+
+/* Fold a motion event into the last one queued for the same device and
+   axis, as long as nothing but other motion has been queued after it.
+   Absolute positions take the newest value, relative motion adds up.
+ */
+/*                           -- called with the queue locked */
+static int SDL_CoalesceEvent(const SDL_Event *event, Uint32 timestamp)
+{
+	SDL_Event *queued;
+	int spot, depth;
+
+	if ( !(SDL_EVENTMASK(event->type) & SDL_MOTIONMASK) ) {
+		return(0);
+	}
+	spot = SDL_EventQ.tail;
+	for ( depth = 0; (depth < SDL_COALESCE_DEPTH) &&
+	                 (spot != SDL_EventQ.head); ++depth ) {
+		spot = (spot+SDL_EventQ.size-1)%SDL_EventQ.size;
+		queued = &SDL_EventQ.event[spot];
+		if ( !(SDL_EVENTMASK(queued->type) & SDL_MOTIONMASK) ) {
+			/* Motion can't move past anything else */
+			return(0);
+		}
+		if ( queued->type != event->type ) {
+			continue;
+		}
+		switch (event->type) {
+		    case SDL_MOUSEMOTION:
+			if ( queued->motion.which != event->motion.which ||
+			     queued->motion.state != event->motion.state ) {
+				continue;
+			}
+			queued->motion.x = event->motion.x;
+			queued->motion.y = event->motion.y;
+			queued->motion.xrel = SDL_AddRel(queued->motion.xrel,
+			                                 event->motion.xrel);
+			queued->motion.yrel = SDL_AddRel(queued->motion.yrel,
+			                                 event->motion.yrel);
+			break;
+		    case SDL_JOYAXISMOTION:
+			if ( queued->jaxis.which != event->jaxis.which ||
+			     queued->jaxis.axis != event->jaxis.axis ) {
+				continue;
+			}
+			queued->jaxis.value = event->jaxis.value;
+			break;
+		    case SDL_JOYBALLMOTION:
+			if ( queued->jball.which != event->jball.which ||
+			     queued->jball.ball != event->jball.ball ) {
+				continue;
+			}
+			queued->jball.xrel = SDL_AddRel(queued->jball.xrel,
+			                                event->jball.xrel);
+			queued->jball.yrel = SDL_AddRel(queued->jball.yrel,
+			                                event->jball.yrel);
+			break;
+		}
+		SDL_EventQ.timestamp[spot] = timestamp;
+		++SDL_EventQ.coalesced;
+		return(1);
+	}
+	return(0);
+}
+
+/* Add an event to the ordered queue -- called with the queue locked */
+static int SDL_EnqueueEvent(const SDL_Event *event, Uint32 timestamp)
 {
-	int tail, added;
+	SDL_Event *events;
+	Uint32 *timestamps;
+	int tail, size, used, spot;
+
+	if ( SDL_EventQ.coalesce && SDL_CoalesceEvent(event, timestamp) ) {
+		return(1);
+	}
 
-	tail = (SDL_EventQ.tail+1)%MAXEVENTS;
+	tail = (SDL_EventQ.tail+1)%SDL_EventQ.size;
 	if ( tail == SDL_EventQ.head ) {
+		/* Full, try to grow the queue */
+		size = SDL_EventQ.size * 2;
+		if ( size > SDL_EventQ.max ) {
+			size = SDL_EventQ.max;
+		}
+		events = NULL;
+		timestamps = NULL;
+		if ( size > SDL_EventQ.size ) {
+			events = (SDL_Event *)SDL_malloc(size*sizeof(*events));
+			timestamps = (Uint32 *)
+				SDL_malloc(size*sizeof(*timestamps));
+		}
+		if ( events == NULL || timestamps == NULL ) {
+			/* Overflow */
+			if ( events ) {
+				SDL_free(events);
+			}
+			if ( timestamps ) {
+				SDL_free(timestamps);
+			}
+			return(0);
+		}
+		used = 0;
+		for ( spot = SDL_EventQ.head; spot != SDL_EventQ.tail;
+		      spot = (spot+1)%SDL_EventQ.size ) {
+			events[used] = SDL_EventQ.event[spot];
+			timestamps[used++] = SDL_EventQ.timestamp[spot];
+		}
+		SDL_free(SDL_EventQ.event);
+		SDL_free(SDL_EventQ.timestamp);
+		SDL_EventQ.event = events;
+		SDL_EventQ.timestamp = timestamps;
+		SDL_EventQ.size = size;
+		SDL_EventQ.head = 0;
+		SDL_EventQ.tail = used;
+		tail = used+1;
+	}
+	SDL_EventQ.event[SDL_EventQ.tail] = *event;
+	SDL_EventQ.timestamp[SDL_EventQ.tail] = timestamp;
+	SDL_EventQ.tail = tail;
+
+	used = (SDL_EventQ.tail - SDL_EventQ.head + SDL_EventQ.size) %
+	       SDL_EventQ.size;
+	if ( used > SDL_EventQ.peak ) {
+		SDL_EventQ.peak = used;
+	}
+	return(1);
+}
+
+/* Move the events posted so far to the ordered queue, oldest first.
+   Returns -1 if the ordered queue is full and can't take them all.
+ */
+/*                                       -- called with the queue locked */
+static int SDL_DrainEventInbox(void)
+{
+	int retval = 0;
+#if SDL_EVENTQ_LOCKFREE
+	SDL_EventCell *cell;
+	Uint32 pos;
+
+	for ( pos = SDL_EventQ.inbox_head; ; ++pos ) {
+		cell = &SDL_EventQ.inbox[pos & SDL_EventQ.inbox_mask];
+		if ( cell->sequence != pos+1 ) {
+			/* Empty, or the poster hasn't finished copying it */
+			break;
+		}
+		SDL_EventQ_Barrier();
+		if ( ! SDL_EnqueueEvent(&cell->event, cell->timestamp) ) {
+			retval = -1;
+			break;
+		}
+		SDL_EventQ_Barrier();
+		/* Hand the cell back for the next lap around the ring */
+		cell->sequence = pos + SDL_EventQ.inbox_mask + 1;
+	}
+	SDL_EventQ.inbox_head = pos;
+#endif
+	return(retval);
+}
+
+#if SDL_EVENTQ_LOCKFREE
+/* Post an event without locking, returns 0 if the inbox is full */
+static int SDL_PostEvent(const SDL_Event *event, Uint32 timestamp)
+{
+	SDL_EventCell *cell;
+	Uint32 pos;
+	Sint32 lap;
+
+	pos = SDL_EventQ.inbox_tail;
+	for ( ;; ) {
+		cell = &SDL_EventQ.inbox[pos & SDL_EventQ.inbox_mask];
+		lap = (Sint32)(cell->sequence - pos);
+		if ( lap == 0 ) {
+			/* Free, try to claim it */
+			if ( SDL_EventQ_CAS(&SDL_EventQ.inbox_tail, pos, pos+1) ) {
+				break;
+			}
+		} else if ( lap < 0 ) {
+			/* Still holding an event from the last lap */
+			return(0);
+		}
+		pos = SDL_EventQ.inbox_tail;
+	}
+	cell->event = *event;
+	cell->timestamp = timestamp;
+	SDL_EventQ_Barrier();
+	cell->sequence = pos+1;
+	return(1);
+}
+#endif
+
+/* Add an event to the event queue, returns -1 if it can't be locked */
+static int SDL_AddEvent(SDL_Event *event)
+{
+	SDL_Event copy;
+	Uint32 timestamp;
+	int next, added;
+
+	if ( SDL_EventQ.post_time &&
+	     SDL_EventQ.post_thread == SDL_ThreadID() ) {
+		timestamp = SDL_EventQ.post_time;
+	} else {
+		timestamp = SDL_FrameStatsNow();
+	}
+
+	if (event->type == SDL_SYSWMEVENT) {
+		/* Note that it's possible to lose an event */
+		next = SDL_EventQ_Inc(&SDL_EventQ.wmmsg_next) % MAXWMMSGS;
+		SDL_EventQ.wmmsg[next] = *event->syswm.msg;
+		copy = *event;
+		copy.syswm.msg = &SDL_EventQ.wmmsg[next];
+		event = &copy;
+	}
+	for ( ;; ) {
+#if SDL_EVENTQ_LOCKFREE
+		if ( SDL_PostEvent(event, timestamp) ) {
+			/* Another thread may be waiting for it */
+			SDL_WakeEventFDs();
+			return(1);
+		}
+#endif
+		/* The inbox is full: make room for it the slow way */
+		if ( SDL_mutexP(SDL_EventQ.lock) < 0 ) {
+			return(-1);
+		}
+		if ( SDL_DrainEventInbox() < 0 ) {
+			added = 0;
+		} else if ( SDL_EventQ.inbox_head == SDL_EventQ.inbox_tail ) {
+			/* Nothing posted before it is left behind */
+			added = SDL_EnqueueEvent(event, timestamp);
+		} else {
+			/* Somebody is still copying into the inbox, wait
+			   for them so we don't jump ahead of their events */
+			added = -1;
+		}
+		SDL_mutexV(SDL_EventQ.lock);
+		if ( added >= 0 ) {
+			break;
+		}
+	}
+	if ( ! added ) {
 		/* Overflow, drop event */
-		added = 0;
+		SDL_EventQ_Inc(&SDL_EventQ.dropped[event->type % SDL_NUMEVENTS]);
 	} else {
-		SDL_EventQ.event[SDL_EventQ.tail] = *event;
-		if (event->type == SDL_SYSWMEVENT) {
-			/* Note that it's possible to lose an event */
-			int next = SDL_EventQ.wmmsg_next;
-			SDL_EventQ.wmmsg[next] = *event->syswm.msg;
-		        SDL_EventQ.event[SDL_EventQ.tail].syswm.msg =
-						&SDL_EventQ.wmmsg[next];
-			SDL_EventQ.wmmsg_next = (next+1)%MAXEVENTS;
-		}
-		SDL_EventQ.tail = tail;
-		added = 1;
+		SDL_WakeEventFDs();
 	}
 	return(added);
 }
 
-/* Cut an event, and return the next valid spot, or the tail */
+/* Take the events matching 'mask' off the front of the queue */
 /*                           -- called with the queue locked */
-static int SDL_CutEvent(int spot)
+static int SDL_CutEvents(SDL_Event *events, int numevents, Uint32 mask)
 {
-	if ( spot == SDL_EventQ.head ) {
-		SDL_EventQ.head = (SDL_EventQ.head+1)%MAXEVENTS;
-		return(SDL_EventQ.head);
-	} else
-	if ( (spot+1)%MAXEVENTS == SDL_EventQ.tail ) {
-		SDL_EventQ.tail = spot;
-		return(SDL_EventQ.tail);
-	} else
-	/* We cut the middle -- shift everything over */
-	{
-		int here, next;
+	int used, spot, keep, next;
+
+	/* One pass to copy them out... */
+	used = 0;
+	spot = SDL_EventQ.head;
+	while ((used < numevents)&&(spot != SDL_EventQ.tail)) {
+		if ( mask & SDL_EVENTMASK(SDL_EventQ.event[spot].type) ) {
+			events[used++] = SDL_EventQ.event[spot];
 
-		/* This can probably be optimized with SDL_memcpy() -- careful! */
-		if ( --SDL_EventQ.tail < 0 ) {
-			SDL_EventQ.tail = MAXEVENTS-1;
+			/* Remember when it happened, for a while */
+			next = SDL_EventQ.delivered_next;
+			SDL_EventQ.delivered[next] = SDL_EventQ.event[spot];
+			SDL_EventQ.delivered_time[next] =
+				SDL_EventQ.timestamp[spot];
+			SDL_EventQ.delivered_next = (next+1)%MAXDELIVERED;
 		}
-		for ( here=spot; here != SDL_EventQ.tail; here = next ) {
-			next = (here+1)%MAXEVENTS;
-			SDL_EventQ.event[here] = SDL_EventQ.event[next];
+		spot = (spot+1)%SDL_EventQ.size;
+	}
+
+	/* ...and one back to the head, closing the gaps by moving the events
+	   that were skipped up against the first one we keep.  Only that
+	   stretch is touched, however many events were taken out of it. */
+	keep = spot;
+	while ( spot != SDL_EventQ.head ) {
+		spot = (spot+SDL_EventQ.size-1)%SDL_EventQ.size;
+		if ( !(mask & SDL_EVENTMASK(SDL_EventQ.event[spot].type)) ) {
+			keep = (keep+SDL_EventQ.size-1)%SDL_EventQ.size;
+			SDL_EventQ.event[keep] = SDL_EventQ.event[spot];
+			SDL_EventQ.timestamp[keep] = SDL_EventQ.timestamp[spot];
 		}
-		return(spot);
 	}
-	/* NOTREACHED */
+	SDL_EventQ.head = keep;
+	return(used);
 }
 
 /* Lock the event queue, take a peep at it, and unlock it */
 int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 								Uint32 mask)
 {
-	int i, used;
+	int i, used, added;
 
 	/* Don't look after we've quit */
 	if ( ! SDL_EventQ.active ) {
 		return(-1);
 	}
-	/* Lock the event queue */
 	used = 0;
-	if ( SDL_mutexP(SDL_EventQ.lock) == 0 ) {
-		if ( action == SDL_ADDEVENT ) {
-			for ( i=0; i<numevents; ++i ) {
-				used += SDL_AddEvent(&events[i]);
+	if ( action == SDL_ADDEVENT ) {
+		/* Adding doesn't lock unless the queue is filling up */
+		for ( i=0; i<numevents; ++i ) {
+			added = SDL_AddEvent(&events[i]);
+			if ( added < 0 ) {
+				SDL_SetError("Couldn't lock event queue");
+				return(-1);
 			}
+			used += added;
+		}
+		return(used);
+	}
+
+	/* Lock the event queue */
+	if ( SDL_mutexP(SDL_EventQ.lock) == 0 ) {
+		SDL_Event tmpevent;
+		int spot;
+
+		SDL_DrainEventInbox();
+
+		/* If 'events' is NULL, just see if they exist */
+		if ( events == NULL ) {
+			action = SDL_PEEKEVENT;
+			numevents = 1;
+			events = &tmpevent;
+		}
+		if ( action == SDL_GETEVENT ) {
+			used = SDL_CutEvents(events, numevents, mask);
 		} else {
-			SDL_Event tmpevent;
-			int spot;
-
-			/* If 'events' is NULL, just see if they exist */
-			if ( events == NULL ) {
-				action = SDL_PEEKEVENT;
-				numevents = 1;
-				events = &tmpevent;
-			}
 			spot = SDL_EventQ.head;
 			while ((used < numevents)&&(spot != SDL_EventQ.tail)) {
 				if ( mask & SDL_EVENTMASK(SDL_EventQ.event[spot].type) ) {
 					events[used++] = SDL_EventQ.event[spot];
-					if ( action == SDL_GETEVENT ) {
-						spot = SDL_CutEvent(spot);
-					} else {
-						spot = (spot+1)%MAXEVENTS;
-					}
-				} else {
-					spot = (spot+1)%MAXEVENTS;
 				}
+				spot = (spot+1)%SDL_EventQ.size;
 			}
 		}
 		SDL_mutexV(SDL_EventQ.lock);
@@ -364,6 +901,67 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 	return(used);
 }
 
+void SDL_SetEventTimestamp(Uint32 usec)
+{
+	SDL_EventQ.post_thread = SDL_ThreadID();
+	SDL_EventQ.post_time = usec;
+}
+
+Uint32 SDL_GetEventTimestamp(const SDL_Event *event)
+{
+	Uint32 timestamp = 0;
+	int i, spot;
+
+	if ( ! SDL_EventQ.active || SDL_mutexP(SDL_EventQ.lock) < 0 ) {
+		return(0);
+	}
+	/* Newest first, in case the same event came twice */
+	for ( i = 1; i <= MAXDELIVERED; ++i ) {
+		spot = (SDL_EventQ.delivered_next+MAXDELIVERED-i)%MAXDELIVERED;
+		if ( SDL_memcmp(&SDL_EventQ.delivered[spot], event,
+		                sizeof(*event)) == 0 ) {
+			timestamp = SDL_EventQ.delivered_time[spot];
+			break;
+		}
+	}
+	/* Maybe it was only peeked at */
+	if ( ! timestamp ) {
+		SDL_DrainEventInbox();
+		for ( spot = SDL_EventQ.head; spot != SDL_EventQ.tail;
+		      spot = (spot+1)%SDL_EventQ.size ) {
+			if ( SDL_memcmp(&SDL_EventQ.event[spot], event,
+			                sizeof(*event)) == 0 ) {
+				timestamp = SDL_EventQ.timestamp[spot];
+				break;
+			}
+		}
+	}
+	SDL_mutexV(SDL_EventQ.lock);
+	return(timestamp);
+}
+
+void SDL_GetEventQueueStats(SDL_EventQueueStats *stats)
+{
+	int i;
+
+	SDL_memset(stats, 0, sizeof(*stats));
+	if ( ! SDL_EventQ.active || SDL_mutexP(SDL_EventQ.lock) < 0 ) {
+		return;
+	}
+	SDL_DrainEventInbox();
+	stats->queued = (SDL_EventQ.tail - SDL_EventQ.head + SDL_EventQ.size) %
+	                SDL_EventQ.size;
+	stats->capacity = SDL_EventQ.size-1;
+	stats->limit = SDL_EventQ.max-1;
+	stats->peak = SDL_EventQ.peak;
+	stats->coalesced = SDL_EventQ.coalesced;
+	for ( i=0; i<SDL_NUMEVENTS; ++i ) {
+		stats->dropped_type[i] = SDL_EventQ.dropped[i];
+		stats->dropped += SDL_EventQ.dropped[i];
+	}
+	SDL_mutexV(SDL_EventQ.lock);
+}
+
 /* Run the system dependent event loops */
 void SDL_PumpEvents(void)
 {
@@ -400,14 +998,41 @@ int SDL_PollEvent (SDL_Event *event)
 	return 1;
 }
 
+int SDL_PollEvents (SDL_Event *events, int numevents, Uint32 mask)
+{
+	SDL_PumpEvents();
+
+	return SDL_PeepEvents(events, numevents, SDL_GETEVENT, mask);
+}
+
 int SDL_WaitEvent (SDL_Event *event)
 {
+	return SDL_WaitEventTimeout(event, -1);
+}
+
+int SDL_WaitEventTimeout (SDL_Event *event, int timeout)
+{
+	Uint32 start = SDL_GetTicks();
+	Uint32 elapsed;
+	int wait;
+
 	while ( 1 ) {
 		SDL_PumpEvents();
 		switch(SDL_PeepEvents(event, 1, SDL_GETEVENT, SDL_ALLEVENTS)) {
 		    case -1: return 0;
 		    case 1: return 1;
-		    case 0: SDL_Delay(10);
+		}
+		wait = -1;
+		if ( timeout >= 0 ) {
+			elapsed = SDL_GetTicks() - start;
+			if ( elapsed >= (Uint32)timeout ) {
+				return 0;
+			}
+			wait = timeout - elapsed;
+		}
+		/* With an event thread it's the one sleeping on the sources */
+		if ( SDL_EventThread || SDL_WaitEventFDs(wait) < 0 ) {
+			SDL_Delay((wait >= 0 && wait < 10) ? wait : 10);
 		}
 	}
 }
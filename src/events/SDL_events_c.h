@@ -33,6 +33,21 @@ extern void SDL_Lock_EventThread(void);
 extern void SDL_Unlock_EventThread(void);
 extern Uint32 SDL_EventThreadID(void);
 
+/* Event sources with a file descriptor, waited on by SDL_WaitEvent().
+   'video' marks input the video driver drains on every PumpEvents();
+   waiting sleeps on the sources only once the driver has added at least
+   one, so a driver that adds any must add all of them.  Other sources
+   only wake a wait when new data arrives.
+ */
+extern int SDL_AddEventFD(int fd, int video);
+extern void SDL_DelEventFD(int fd, int video);
+
+/* The time the events the calling thread posts next really happened, in
+   SDL_FrameStatsNow() microseconds, for drivers that get it from the
+   kernel.  0 goes back to stamping events when they are posted.
+ */
+extern void SDL_SetEventTimestamp(Uint32 usec);
+
 /* Event handler init routines */
 extern int  SDL_AppActiveInit(void);
 extern int  SDL_KeyboardInit(void);
@@ -76,6 +91,9 @@ extern void SDL_ResetKeyboard(void);
 /* Used by the event loop to queue pending keyboard repeat events */
 extern void SDL_CheckKeyRepeat(void);
 
+/* Milliseconds until SDL_CheckKeyRepeat() has work to do, or -1 */
+extern int SDL_KeyRepeatTimeout(void);
+
 /* Used by the OS keyboard code to detect whether or not to do UNICODE */
 #ifndef DEFAULT_UNICODE_TRANSLATION
 #define DEFAULT_UNICODE_TRANSLATION 0	/* Default off because of overhead */
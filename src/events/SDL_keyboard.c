@@ -570,6 +570,26 @@ printf("Keyboard event didn't change state - dropped!\n");
 /*
  * jk 991215 - Added
  */
+int SDL_KeyRepeatTimeout(void)
+{
+	Uint32 interval, wait;
+
+	if ( ! SDL_KeyRepeat.timestamp ) {
+		return(-1);
+	}
+	interval = (SDL_GetTicks() - SDL_KeyRepeat.timestamp);
+	if ( SDL_KeyRepeat.firsttime ) {
+		wait = (Uint32)SDL_KeyRepeat.delay;
+	} else {
+		wait = (Uint32)SDL_KeyRepeat.interval;
+	}
+	/* SDL_CheckKeyRepeat() fires once the interval is over the wait */
+	if ( interval > wait ) {
+		return(0);
+	}
+	return((int)(wait - interval) + 1);
+}
+
 void SDL_CheckKeyRepeat(void)
 {
 	if ( SDL_KeyRepeat.timestamp ) {
@@ -30,6 +30,7 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <limits.h>		/* For the definition of PATH_MAX */
+#include <time.h>
 #include <linux/joystick.h>
 #if SDL_INPUT_LINUXEV
 #include <linux/input.h>
@@ -38,6 +39,7 @@
 #include "SDL_joystick.h"
 #include "../SDL_sysjoystick.h"
 #include "../SDL_joystick_c.h"
+#include "../../events/SDL_events_c.h"
 
 /* Special joystick configurations */
 static struct {
@@ -680,6 +682,11 @@ static SDL_bool EV_ConfigJoystick(SDL_Joystick *joystick, int fd)
 	     (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absbit)), absbit) >= 0) &&
 	     (ioctl(fd, EVIOCGBIT(EV_REL, sizeof(relbit)), relbit) >= 0) ) {
 		joystick->hwdata->is_hid = SDL_TRUE;
+#ifdef EVIOCSCLOCKID
+		/* Event times on the clock SDL_GetEventTimestamp() uses */
+		t = CLOCK_MONOTONIC;
+		ioctl(fd, EVIOCSCLOCKID, &t);
+#endif
 
 		/* Get the number of buttons, axes, and other thingamajigs */
 		for ( i=BTN_JOYSTICK; i < KEY_MAX; ++i ) {
@@ -831,6 +838,9 @@ int SDL_SYS_JoystickOpen(SDL_Joystick *joystick)
 	/* Set the joystick to non-blocking read mode */
 	fcntl(fd, F_SETFL, O_NONBLOCK);
 
+	/* Let SDL_WaitEvent() wake up on joystick input */
+	SDL_AddEventFD(fd, 0);
+
 	/* Get the number of buttons and axes on the joystick */
 #ifndef NO_LOGICAL_JOYSTICKS
 	if (realjoy)
@@ -1090,6 +1100,18 @@ static __inline__ void EV_HandleEvents(SDL_Joystick *joystick)
 	while ((len=read(joystick->hwdata->fd, events, (sizeof events))) > 0) {
 		len /= sizeof(events[0]);
 		for ( i=0; i<len; ++i ) {
+#if HAVE_CLOCK_GETTIME
+			/* Stamp the events with the time the kernel saw them */
+#ifdef input_event_sec
+			SDL_SetEventTimestamp(
+				(Uint32)events[i].input_event_sec * 1000000 +
+				(Uint32)events[i].input_event_usec);
+#else
+			SDL_SetEventTimestamp(
+				(Uint32)events[i].time.tv_sec * 1000000 +
+				(Uint32)events[i].time.tv_usec);
+#endif
+#endif /* HAVE_CLOCK_GETTIME */
 			code = events[i].code;
 			switch (events[i].type) {
 			    case EV_KEY:
@@ -1149,6 +1171,7 @@ static __inline__ void EV_HandleEvents(SDL_Joystick *joystick)
 			}
 		}
 	}
+	SDL_SetEventTimestamp(0);
 }
 #endif /* SDL_INPUT_LINUXEV */
 
@@ -1192,7 +1215,10 @@ void SDL_SYS_JoystickClose(SDL_Joystick *joystick)
 #ifndef NO_LOGICAL_JOYSTICKS
 		if (SDL_joylist[joystick->index].fname != NULL)
 #endif
-		close(joystick->hwdata->fd);
+		{
+			SDL_DelEventFD(joystick->hwdata->fd, 0);
+			close(joystick->hwdata->fd);
+		}
 		if ( joystick->hwdata->hats ) {
 			SDL_free(joystick->hwdata->hats);
 		}
@@ -24,6 +24,7 @@
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
+#include "SDL_blitthreads_c.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
 
@@ -93,8 +94,11 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 		info.dst = dst->format;
 		RunBlit = src->map->sw_data->blit;
 
-		/* Run the actual software blit */
-		RunBlit(&info);
+		/* Run the actual software blit, in bands if it's big */
+		if ( src->pixels == dst->pixels ||
+		     !SDL_BlitThreaded(RunBlit, &info, src->pitch, dst->pitch) ) {
+			RunBlit(&info);
+		}
 	}
 
 	/* We need to unlock the surfaces if they're locked */
@@ -26,6 +26,38 @@
 
 #include "SDL_endian.h"
 
+/* The SSE2 and NEON blitters assume little endian pixel layout */
+#if defined(__SSE2__) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define SDL_SSE2_BLITTERS	1
+#include <emmintrin.h>
+#endif
+
+/* The NEON blitters are also built when the target is an ARMv7 without
+   NEON, as in a generic armhf build.  The code between SDL_NEON_BEGIN and
+   SDL_NEON_END is then compiled for the NEON FPU, and it is only called
+   after SDL_HasNEON() has found one.
+ */
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && \
+    (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define SDL_NEON_BLITTERS	1
+#include <arm_neon.h>
+#elif defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 8) && \
+      defined(__arm__) && defined(__ARM_FP) && (__ARM_ARCH >= 7) && \
+      defined(__ARM_ARCH_PROFILE) && (__ARM_ARCH_PROFILE == 'A') && \
+      (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define SDL_NEON_BLITTERS	1
+#define SDL_NEON_BEGIN	_Pragma("GCC push_options") \
+			_Pragma("GCC target(\"fpu=neon\")")
+#define SDL_NEON_END	_Pragma("GCC pop_options")
+SDL_NEON_BEGIN
+#include <arm_neon.h>
+SDL_NEON_END
+#endif
+#ifndef SDL_NEON_BEGIN
+#define SDL_NEON_BEGIN
+#define SDL_NEON_END
+#endif
+
 /* The structure passed to the low level blit functions */
 typedef struct {
 	Uint8 *s_pixels;
@@ -2591,6 +2591,462 @@ static void BlitARGBto555PixelAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+/*
+ * SSE2 and NEON versions of the blends above.  They do the same packed
+ * 32-bit math as the C code, lane for lane (wrapping multiply, logical
+ * shifts), so the results are bit for bit the same.  The columns left
+ * over by the vector loop are done afterwards by the C blitter.
+ */
+static void BlitAlphaTail(SDL_BlitInfo *info, int done, SDL_loblit blit)
+{
+	SDL_BlitInfo tail = *info;
+	int srcbpp = info->src->BytesPerPixel;
+	int dstbpp = info->dst->BytesPerPixel;
+
+	if(done < info->d_width) {
+		tail.s_pixels += done * srcbpp;
+		tail.s_width -= done;
+		tail.s_skip += done * srcbpp;
+		tail.d_pixels += done * dstbpp;
+		tail.d_width -= done;
+		tail.d_skip += done * dstbpp;
+		blit(&tail);
+	}
+}
+#endif /* SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS */
+
+#if SDL_SSE2_BLITTERS
+/* x * a in each 32-bit lane, modulo 2^32; a is in both 16-bit halves */
+static __inline__ __m128i MulLo32SSE2(__m128i x, __m128i a)
+{
+	return _mm_add_epi32(_mm_mullo_epi16(x, a),
+			     _mm_slli_epi32(_mm_mulhi_epu16(x, a), 16));
+}
+
+/* fast ARGB888->(A)RGB888 blending with pixel alpha, 4 pixels at a time */
+static void BlitRGBtoRGBPixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width & ~3;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 2) + (info->d_width - width);
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 2) + (info->d_width - width);
+	const __m128i rbmask = _mm_set1_epi32(0x00ff00ff);
+	const __m128i gmask = _mm_set1_epi32(0x0000ff00);
+	const __m128i amask = _mm_set1_epi32(0xff000000);
+	const __m128i opaque = _mm_set1_epi32(SDL_ALPHA_OPAQUE);
+	const __m128i zero = _mm_setzero_si128();
+	int n;
+
+	while(width && height--) {
+		for(n = width; n; n -= 4) {
+			__m128i s = _mm_loadu_si128((__m128i *)srcp);
+			__m128i alpha = _mm_srli_epi32(s, 24);
+			__m128i a, d, s1, d1, o;
+
+			/* all four transparent, nothing to do */
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) != 0xffff) {
+				a = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+				d = _mm_loadu_si128((__m128i *)dstp);
+				s1 = _mm_and_si128(s, rbmask);
+				d1 = _mm_and_si128(d, rbmask);
+				d1 = _mm_and_si128(_mm_add_epi32(d1, _mm_srli_epi32(
+					MulLo32SSE2(_mm_sub_epi32(s1, d1), a), 8)), rbmask);
+				s1 = _mm_and_si128(s, gmask);
+				o = _mm_and_si128(d, gmask);
+				o = _mm_and_si128(_mm_add_epi32(o, _mm_srli_epi32(
+					MulLo32SSE2(_mm_sub_epi32(s1, o), a), 8)), gmask);
+				d = _mm_or_si128(_mm_or_si128(d1, o),
+						 _mm_and_si128(d, amask));
+				/* opaque pixels are copied */
+				o = _mm_cmpeq_epi32(alpha, opaque);
+				d = _mm_or_si128(_mm_and_si128(o, s),
+						 _mm_andnot_si128(o, d));
+				_mm_storeu_si128((__m128i *)dstp, d);
+			}
+			srcp += 4;
+			dstp += 4;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+	BlitAlphaTail(info, width, BlitRGBtoRGBPixelAlpha);
+}
+
+/* Blends 4 ARGB8888 pixels onto 4 RGB565 (or RGB555) pixels in 32-bit lanes */
+static __inline__ __m128i BlitARGBto16PixelSSE2(__m128i s, __m128i d, int is565)
+{
+	const __m128i b = _mm_set1_epi32(0x1f);
+	__m128i alpha = _mm_srli_epi32(s, 27); /* downscale alpha to 5 bits */
+	__m128i a = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+	__m128i dst = d;
+	__m128i mask, o, opaque;
+
+	if(is565) {
+		mask = _mm_set1_epi32(0x07e0f81f);
+		opaque = _mm_add_epi32(_mm_add_epi32(
+			_mm_and_si128(_mm_srli_epi32(s, 8), _mm_set1_epi32(0xf800)),
+			_mm_and_si128(_mm_srli_epi32(s, 5), _mm_set1_epi32(0x7e0))),
+			_mm_and_si128(_mm_srli_epi32(s, 3), b));
+		s = _mm_add_epi32(_mm_add_epi32(
+			_mm_slli_epi32(_mm_and_si128(s, _mm_set1_epi32(0xfc00)), 11),
+			_mm_and_si128(_mm_srli_epi32(s, 8), _mm_set1_epi32(0xf800))),
+			_mm_and_si128(_mm_srli_epi32(s, 3), b));
+	} else {
+		mask = _mm_set1_epi32(0x03e07c1f);
+		opaque = _mm_add_epi32(_mm_add_epi32(
+			_mm_and_si128(_mm_srli_epi32(s, 9), _mm_set1_epi32(0x7c00)),
+			_mm_and_si128(_mm_srli_epi32(s, 6), _mm_set1_epi32(0x3e0))),
+			_mm_and_si128(_mm_srli_epi32(s, 3), b));
+		s = _mm_add_epi32(_mm_add_epi32(
+			_mm_slli_epi32(_mm_and_si128(s, _mm_set1_epi32(0xf800)), 10),
+			_mm_and_si128(_mm_srli_epi32(s, 9), _mm_set1_epi32(0x7c00))),
+			_mm_and_si128(_mm_srli_epi32(s, 3), b));
+	}
+	d = _mm_and_si128(_mm_or_si128(d, _mm_slli_epi32(d, 16)), mask);
+	d = _mm_and_si128(_mm_add_epi32(d, _mm_srli_epi32(
+		MulLo32SSE2(_mm_sub_epi32(s, d), a), 5)), mask);
+	d = _mm_or_si128(d, _mm_srli_epi32(d, 16));
+	o = _mm_cmpeq_epi32(alpha, _mm_set1_epi32(SDL_ALPHA_OPAQUE >> 3));
+	d = _mm_or_si128(_mm_and_si128(o, opaque), _mm_andnot_si128(o, d));
+	/* transparent pixels are left alone, even the unused 555 bit */
+	o = _mm_cmpeq_epi32(alpha, _mm_setzero_si128());
+	d = _mm_or_si128(_mm_and_si128(o, dst), _mm_andnot_si128(o, d));
+	/* sign extend the low 16 bits, so the signed pack keeps them */
+	return _mm_srai_epi32(_mm_slli_epi32(d, 16), 16);
+}
+
+static void BlitARGBto16PixelAlphaSSE2(SDL_BlitInfo *info, int is565)
+{
+	int width = info->d_width & ~7;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 2) + (info->d_width - width);
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 1) + (info->d_width - width);
+	const __m128i zero = _mm_setzero_si128();
+	int n;
+
+	while(width && height--) {
+		for(n = width; n; n -= 8) {
+			__m128i d = _mm_loadu_si128((__m128i *)dstp);
+			__m128i lo = BlitARGBto16PixelSSE2(
+				_mm_loadu_si128((__m128i *)srcp),
+				_mm_unpacklo_epi16(d, zero), is565);
+			__m128i hi = BlitARGBto16PixelSSE2(
+				_mm_loadu_si128((__m128i *)(srcp + 4)),
+				_mm_unpackhi_epi16(d, zero), is565);
+			_mm_storeu_si128((__m128i *)dstp, _mm_packs_epi32(lo, hi));
+			srcp += 8;
+			dstp += 8;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+	BlitAlphaTail(info, width, is565 ? BlitARGBto565PixelAlpha
+					 : BlitARGBto555PixelAlpha);
+}
+
+/* fast ARGB8888->RGB565 blending with pixel alpha */
+static void BlitARGBto565PixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaSSE2(info, 1);
+}
+
+/* fast ARGB8888->RGB555 blending with pixel alpha */
+static void BlitARGBto555PixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaSSE2(info, 0);
+}
+
+/* Blends 4 pixels in 32-bit lanes, both as G0RAB (mask) */
+static __inline__ __m128i Blit16SurfaceSSE2(__m128i s, __m128i d,
+					    __m128i a, __m128i mask)
+{
+	s = _mm_and_si128(_mm_or_si128(s, _mm_slli_epi32(s, 16)), mask);
+	d = _mm_and_si128(_mm_or_si128(d, _mm_slli_epi32(d, 16)), mask);
+	d = _mm_and_si128(_mm_add_epi32(d, _mm_srli_epi32(
+		MulLo32SSE2(_mm_sub_epi32(s, d), a), 5)), mask);
+	d = _mm_or_si128(d, _mm_srli_epi32(d, 16));
+	return _mm_srai_epi32(_mm_slli_epi32(d, 16), 16);
+}
+
+/*
+ * RGB565 or RGB555 blending with surface alpha, 8 pixels at a time.
+ * mask is the G0RAB layout, mask128 the one Blit16to16SurfaceAlpha128()
+ * uses for the 50% special case.
+ */
+static void Blit16to16SurfaceAlphaSSE2(SDL_BlitInfo *info, Uint32 mask,
+				       Uint16 mask128, SDL_loblit blit)
+{
+	unsigned alpha = info->src->alpha;
+	int width = info->d_width & ~7;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 1) + (info->d_width - width);
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 1) + (info->d_width - width);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i m = _mm_set1_epi32(mask);
+	const __m128i m128 = _mm_set1_epi16(mask128);
+	const __m128i a = _mm_set1_epi16(alpha >> 3); /* downscale to 5 bits */
+	int n;
+
+	while(width && height--) {
+		for(n = width; n; n -= 8) {
+			__m128i s = _mm_loadu_si128((__m128i *)srcp);
+			__m128i d = _mm_loadu_si128((__m128i *)dstp);
+
+			if(alpha == 128) {
+				/* BLEND16_50: the masked sums are even */
+				d = _mm_add_epi16(_mm_avg_epu16(
+					_mm_and_si128(s, m128),
+					_mm_and_si128(d, m128)),
+					_mm_andnot_si128(m128, _mm_and_si128(s, d)));
+			} else {
+				d = _mm_packs_epi32(
+					Blit16SurfaceSSE2(
+						_mm_unpacklo_epi16(s, zero),
+						_mm_unpacklo_epi16(d, zero), a, m),
+					Blit16SurfaceSSE2(
+						_mm_unpackhi_epi16(s, zero),
+						_mm_unpackhi_epi16(d, zero), a, m));
+			}
+			_mm_storeu_si128((__m128i *)dstp, d);
+			srcp += 8;
+			dstp += 8;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+	BlitAlphaTail(info, width, blit);
+}
+
+/* fast RGB565->RGB565 blending with surface alpha */
+static void Blit565to565SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaSSE2(info, 0x07e0f81f, 0xf7de,
+				   Blit565to565SurfaceAlpha);
+}
+
+/* fast RGB555->RGB555 blending with surface alpha */
+static void Blit555to555SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaSSE2(info, 0x03e07c1f, 0xfbde,
+				   Blit555to555SurfaceAlpha);
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+#if SDL_NEON_BLITTERS
+SDL_NEON_BEGIN
+/* fast ARGB888->(A)RGB888 blending with pixel alpha, 4 pixels at a time */
+static void BlitRGBtoRGBPixelAlphaNEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width & ~3;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 2) + (info->d_width - width);
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 2) + (info->d_width - width);
+	const uint32x4_t rbmask = vdupq_n_u32(0x00ff00ff);
+	const uint32x4_t gmask = vdupq_n_u32(0x0000ff00);
+	const uint32x4_t amask = vdupq_n_u32(0xff000000);
+	const uint32x4_t opaque = vdupq_n_u32(SDL_ALPHA_OPAQUE);
+	int n;
+
+	while(width && height--) {
+		for(n = width; n; n -= 4) {
+			uint32x4_t s = vld1q_u32(srcp);
+			uint32x4_t alpha = vshrq_n_u32(s, 24);
+			uint32x2_t any = vorr_u32(vget_low_u32(alpha),
+						  vget_high_u32(alpha));
+			uint32x4_t d, s1, d1, g;
+
+			/* all four transparent, nothing to do */
+			if(vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) {
+				d = vld1q_u32(dstp);
+				s1 = vandq_u32(s, rbmask);
+				d1 = vandq_u32(d, rbmask);
+				d1 = vandq_u32(vaddq_u32(d1, vshrq_n_u32(
+					vmulq_u32(vsubq_u32(s1, d1), alpha), 8)), rbmask);
+				s1 = vandq_u32(s, gmask);
+				g = vandq_u32(d, gmask);
+				g = vandq_u32(vaddq_u32(g, vshrq_n_u32(
+					vmulq_u32(vsubq_u32(s1, g), alpha), 8)), gmask);
+				d = vorrq_u32(vorrq_u32(d1, g), vandq_u32(d, amask));
+				/* opaque pixels are copied */
+				d = vbslq_u32(vceqq_u32(alpha, opaque), s, d);
+				vst1q_u32(dstp, d);
+			}
+			srcp += 4;
+			dstp += 4;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+	BlitAlphaTail(info, width, BlitRGBtoRGBPixelAlpha);
+}
+
+/* Blends 4 ARGB8888 pixels onto 4 RGB565 (or RGB555) pixels in 32-bit lanes */
+static __inline__ uint16x4_t BlitARGBto16PixelNEON(uint32x4_t s, uint16x4_t dst,
+						   int is565)
+{
+	const uint32x4_t b = vdupq_n_u32(0x1f);
+	uint32x4_t alpha = vshrq_n_u32(s, 27); /* downscale alpha to 5 bits */
+	uint32x4_t d = vmovl_u16(dst);
+	uint32x4_t mask, opaque;
+
+	if(is565) {
+		mask = vdupq_n_u32(0x07e0f81f);
+		opaque = vaddq_u32(vaddq_u32(
+			vandq_u32(vshrq_n_u32(s, 8), vdupq_n_u32(0xf800)),
+			vandq_u32(vshrq_n_u32(s, 5), vdupq_n_u32(0x7e0))),
+			vandq_u32(vshrq_n_u32(s, 3), b));
+		s = vaddq_u32(vaddq_u32(
+			vshlq_n_u32(vandq_u32(s, vdupq_n_u32(0xfc00)), 11),
+			vandq_u32(vshrq_n_u32(s, 8), vdupq_n_u32(0xf800))),
+			vandq_u32(vshrq_n_u32(s, 3), b));
+	} else {
+		mask = vdupq_n_u32(0x03e07c1f);
+		opaque = vaddq_u32(vaddq_u32(
+			vandq_u32(vshrq_n_u32(s, 9), vdupq_n_u32(0x7c00)),
+			vandq_u32(vshrq_n_u32(s, 6), vdupq_n_u32(0x3e0))),
+			vandq_u32(vshrq_n_u32(s, 3), b));
+		s = vaddq_u32(vaddq_u32(
+			vshlq_n_u32(vandq_u32(s, vdupq_n_u32(0xf800)), 10),
+			vandq_u32(vshrq_n_u32(s, 9), vdupq_n_u32(0x7c00))),
+			vandq_u32(vshrq_n_u32(s, 3), b));
+	}
+	d = vandq_u32(vorrq_u32(d, vshlq_n_u32(d, 16)), mask);
+	d = vandq_u32(vaddq_u32(d, vshrq_n_u32(
+		vmulq_u32(vsubq_u32(s, d), alpha), 5)), mask);
+	d = vorrq_u32(d, vshrq_n_u32(d, 16));
+	d = vbslq_u32(vceqq_u32(alpha, vdupq_n_u32(SDL_ALPHA_OPAQUE >> 3)),
+		      opaque, d);
+	/* transparent pixels are left alone, even the unused 555 bit */
+	d = vbslq_u32(vceqq_u32(alpha, vdupq_n_u32(0)), vmovl_u16(dst), d);
+	return vmovn_u32(d);
+}
+
+static void BlitARGBto16PixelAlphaNEON(SDL_BlitInfo *info, int is565)
+{
+	int width = info->d_width & ~7;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 2) + (info->d_width - width);
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 1) + (info->d_width - width);
+	int n;
+
+	while(width && height--) {
+		for(n = width; n; n -= 8) {
+			uint16x8_t d = vld1q_u16(dstp);
+			uint16x4_t lo = BlitARGBto16PixelNEON(vld1q_u32(srcp),
+						vget_low_u16(d), is565);
+			uint16x4_t hi = BlitARGBto16PixelNEON(vld1q_u32(srcp + 4),
+						vget_high_u16(d), is565);
+			vst1q_u16(dstp, vcombine_u16(lo, hi));
+			srcp += 8;
+			dstp += 8;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+	BlitAlphaTail(info, width, is565 ? BlitARGBto565PixelAlpha
+					 : BlitARGBto555PixelAlpha);
+}
+
+/* fast ARGB8888->RGB565 blending with pixel alpha */
+static void BlitARGBto565PixelAlphaNEON(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaNEON(info, 1);
+}
+
+/* fast ARGB8888->RGB555 blending with pixel alpha */
+static void BlitARGBto555PixelAlphaNEON(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaNEON(info, 0);
+}
+
+/* Blends 4 pixels in 32-bit lanes, both as G0RAB (mask) */
+static __inline__ uint16x4_t Blit16SurfaceNEON(uint16x4_t src, uint16x4_t dst,
+					       uint32x4_t a, uint32x4_t mask)
+{
+	uint32x4_t s = vmovl_u16(src);
+	uint32x4_t d = vmovl_u16(dst);
+
+	s = vandq_u32(vorrq_u32(s, vshlq_n_u32(s, 16)), mask);
+	d = vandq_u32(vorrq_u32(d, vshlq_n_u32(d, 16)), mask);
+	d = vandq_u32(vaddq_u32(d, vshrq_n_u32(
+		vmulq_u32(vsubq_u32(s, d), a), 5)), mask);
+	return vmovn_u32(vorrq_u32(d, vshrq_n_u32(d, 16)));
+}
+
+/*
+ * RGB565 or RGB555 blending with surface alpha, 8 pixels at a time.
+ * mask is the G0RAB layout, mask128 the one Blit16to16SurfaceAlpha128()
+ * uses for the 50% special case.
+ */
+static void Blit16to16SurfaceAlphaNEON(SDL_BlitInfo *info, Uint32 mask,
+				       Uint16 mask128, SDL_loblit blit)
+{
+	unsigned alpha = info->src->alpha;
+	int width = info->d_width & ~7;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 1) + (info->d_width - width);
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 1) + (info->d_width - width);
+	const uint32x4_t m = vdupq_n_u32(mask);
+	const uint16x8_t m128 = vdupq_n_u16(mask128);
+	const uint32x4_t a = vdupq_n_u32(alpha >> 3); /* downscale to 5 bits */
+	int n;
+
+	while(width && height--) {
+		for(n = width; n; n -= 8) {
+			uint16x8_t s = vld1q_u16(srcp);
+			uint16x8_t d = vld1q_u16(dstp);
+
+			if(alpha == 128) {
+				/* BLEND16_50, halving add can't overflow */
+				d = vaddq_u16(vhaddq_u16(vandq_u16(s, m128),
+							 vandq_u16(d, m128)),
+					      vbicq_u16(vandq_u16(s, d), m128));
+			} else {
+				d = vcombine_u16(
+					Blit16SurfaceNEON(vget_low_u16(s),
+							  vget_low_u16(d), a, m),
+					Blit16SurfaceNEON(vget_high_u16(s),
+							  vget_high_u16(d), a, m));
+			}
+			vst1q_u16(dstp, d);
+			srcp += 8;
+			dstp += 8;
+		}
+		srcp += srcskip;
+		dstp += dstskip;
+	}
+	BlitAlphaTail(info, width, blit);
+}
+
+/* fast RGB565->RGB565 blending with surface alpha */
+static void Blit565to565SurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaNEON(info, 0x07e0f81f, 0xf7de,
+				   Blit565to565SurfaceAlpha);
+}
+
+/* fast RGB555->RGB555 blending with surface alpha */
+static void Blit555to555SurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaNEON(info, 0x03e07c1f, 0xfbde,
+				   Blit555to555SurfaceAlpha);
+}
+SDL_NEON_END
+#endif /* SDL_NEON_BLITTERS */
+
 /* General (slow) N->N blending with per-surface alpha */
 static void BlitNtoNSurfaceAlpha(SDL_BlitInfo *info)
 {
@@ -2758,6 +3214,16 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		if(SDL_HasMMX())
 			return Blit565to565SurfaceAlphaMMX;
 		else
+#endif
+#if SDL_SSE2_BLITTERS
+		if(SDL_HasSSE2())
+			return Blit565to565SurfaceAlphaSSE2;
+		else
+#endif
+#if SDL_NEON_BLITTERS
+		if(SDL_HasNEON())
+			return Blit565to565SurfaceAlphaNEON;
+		else
 #endif
 			return Blit565to565SurfaceAlpha;
 		    }
@@ -2767,6 +3233,16 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		if(SDL_HasMMX())
 			return Blit555to555SurfaceAlphaMMX;
 		else
+#endif
+#if SDL_SSE2_BLITTERS
+		if(SDL_HasSSE2())
+			return Blit555to555SurfaceAlphaSSE2;
+		else
+#endif
+#if SDL_NEON_BLITTERS
+		if(SDL_HasNEON())
+			return Blit555to555SurfaceAlphaNEON;
+		else
 #endif
 			return Blit555to555SurfaceAlpha;
 		    }
@@ -2827,10 +3303,27 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 	       && sf->Gmask == 0xff00
 	       && ((sf->Rmask == 0xff && df->Rmask == 0x1f)
 		   || (sf->Bmask == 0xff && df->Bmask == 0x1f))) {
-		if(df->Gmask == 0x7e0)
+		if(df->Gmask == 0x7e0) {
+#if SDL_SSE2_BLITTERS
+		    if(SDL_HasSSE2())
+			return BlitARGBto565PixelAlphaSSE2;
+#endif
+#if SDL_NEON_BLITTERS
+		    if(SDL_HasNEON())
+			return BlitARGBto565PixelAlphaNEON;
+#endif
 		    return BlitARGBto565PixelAlpha;
-		else if(df->Gmask == 0x3e0)
+		} else if(df->Gmask == 0x3e0) {
+#if SDL_SSE2_BLITTERS
+		    if(SDL_HasSSE2())
+			return BlitARGBto555PixelAlphaSSE2;
+#endif
+#if SDL_NEON_BLITTERS
+		    if(SDL_HasNEON())
+			return BlitARGBto555PixelAlphaNEON;
+#endif
 		    return BlitARGBto555PixelAlpha;
+		}
 	    }
 	    return BlitNtoNPixelAlpha;
 
@@ -2859,6 +3352,14 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 			if(!(surface->map->dst->flags & SDL_HWSURFACE)
 				&& SDL_HasAltiVec())
 				return BlitRGBtoRGBPixelAlphaAltivec;
+#endif
+#if SDL_SSE2_BLITTERS
+			if(SDL_HasSSE2())
+				return BlitRGBtoRGBPixelAlphaSSE2;
+#endif
+#if SDL_NEON_BLITTERS
+			if(SDL_HasNEON())
+				return BlitRGBtoRGBPixelAlphaNEON;
 #endif
 			return BlitRGBtoRGBPixelAlpha;
 		}
@@ -28,6 +28,12 @@
 
 /* Functions to blit from N-bit surfaces to other surfaces */
 
+#if SDL_NEON_BLITTERS
+#define NEON_BLIT_FEATURES	(SDL_HasNEON() ? 16 : 0)
+#else
+#define NEON_BLIT_FEATURES	0
+#endif
+
 #if SDL_ALTIVEC_BLITTERS
 #if __MWERKS__
 #pragma altivec_model on
@@ -828,6 +834,10 @@ static Uint32 GetBlitFeatures( void )
                 /* Feature 4 is dont-use-prefetch */
                 /* !!!! FIXME: Check for G5 or later, not the cache size! Always prefetch on a G4. */
                 | ((GetL3CacheSize() == 0) ? 4 : 0)
+                /* Feature 8 is has-SSE2 */
+                | ((SDL_HasSSE2()) ? 8 : 0)
+                /* Feature 16 is has-NEON */
+                | NEON_BLIT_FEATURES
             );
         }
     }
@@ -837,10 +847,521 @@ static Uint32 GetBlitFeatures( void )
 #pragma altivec_model off
 #endif
 #else
-/* Feature 1 is has-MMX */
-#define GetBlitFeatures() ((Uint32)(SDL_HasMMX() ? 1 : 0))
+/* Feature 1 is has-MMX, 8 is has-SSE2, 16 is has-NEON */
+#define GetBlitFeatures() ((Uint32)((SDL_HasMMX() ? 1 : 0) | \
+                                    (SDL_HasSSE2() ? 8 : 0) | \
+                                    NEON_BLIT_FEATURES))
 #endif
 
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+/* SSE2 and NEON versions of the common conversions.  Each one does 8
+   pixels at a time (4 for SSE2 24-bit sources) and finishes the row with
+   the same math done one pixel at a time.  All of them take the 32-bit
+   side as xRGB or xBGR and work out which from the formats; the alpha
+   byte gets the surface alpha when the destination has alpha, as in
+   BlitNtoN(), or is copied for 32 to 32 when both sides have it.  The
+   16 to 32 one instead sets it opaque, like the LUT blitters it replaces.
+ */
+
+/* RGB 5-6-5 to 8-8-8.  Without destination alpha BlitNtoN() shifts the
+   bits up and leaves the low ones clear.  With it, the RGB565_ARGB8888_LUT
+   tables scale each channel by 255/31 or 255/63, rounding down, and look
+   up green in two halves that are truncated separately.
+ */
+#define RGB565_R8(p)	(((p)>>8)&0xF8)
+#define RGB565_G8(p)	(((p)>>3)&0xFC)
+#define RGB565_B8(p)	(((p)<<3)&0xF8)
+#define RGB565_R8_LUT(p)	((((p)>>11)*1053)>>7)
+#define RGB565_G8_LUT(p)	(((((p)>>8)&0x07)*259>>3)+(((p)>>3)&0x1C))
+#define RGB565_B8_LUT(p)	((((p)&0x001F)*1053)>>7)
+#define RGB565_RGB555(p)	((((p)>>1)&0x7FE0)|((p)&0x001F))
+#define RGB555_RGB565(p)	((((p)&0x7FE0)<<1)|((p)&0x001F))
+#define RGB888_TO_RGB565(p)	((Uint16)((((p)&0x00F80000)>>8)| \
+				          (((p)&0x0000FC00)>>5)| \
+				          (((p)&0x000000F8)>>3)))
+#define SWAP_RB(p)	((((p)>>16)&0xFF)|((p)&0xFF00FF00)|(((p)&0xFF)<<16))
+
+/* The alpha bits to set, 0 if the destination has no alpha */
+#define SIMD_ALPHA(info) ((info)->dst->Amask ? \
+	(((info)->src->alpha >> (info)->dst->Aloss) << (info)->dst->Ashift) : 0)
+
+/* Is the 32-bit side the other way around from xRGB? */
+#define SIMD_SWAP16(info)	((info)->dst->Rmask != 0x00FF0000)
+#define SIMD_SWAP32(info)	((info)->src->Rmask != (info)->dst->Rmask)
+
+/* 'alpha' is the destination Amask, set to opaque like the LUT blitters */
+static Uint32 Pixel_RGB565_32(Uint32 p, int swap, Uint32 alpha)
+{
+	Uint32 r, g, b;
+
+	if ( alpha ) {
+		r = RGB565_R8_LUT(p);
+		g = RGB565_G8_LUT(p);
+		b = RGB565_B8_LUT(p);
+	} else {
+		r = RGB565_R8(p);
+		g = RGB565_G8(p);
+		b = RGB565_B8(p);
+	}
+	if ( swap ) {
+		return (b<<16)|(g<<8)|r|alpha;
+	}
+	return (r<<16)|(g<<8)|b|alpha;
+}
+
+static Uint32 Pixel_24to32(const Uint8 *src, int swap, Uint32 alpha)
+{
+	Uint32 p = src[0] | (src[1] << 8) | (src[2] << 16);
+
+	return (swap ? SWAP_RB(p) : p) | alpha;
+}
+#endif /* SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS */
+
+#if SDL_SSE2_BLITTERS
+static void Blit_RGB565_32SSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int swap = SIMD_SWAP16(info);
+	Uint32 alpha = info->dst->Amask;
+	const __m128i alphav = _mm_set1_epi32(alpha);
+	const __m128i scale = _mm_set1_epi16(1053);
+	int n;
+
+	while ( height-- ) {
+		for ( n = width; n >= 8; n -= 8 ) {
+			__m128i p = _mm_loadu_si128((const __m128i *)src);
+			__m128i r, g, b, lo, hi;
+
+			if ( alpha ) {
+				r = _mm_srli_epi16(_mm_mullo_epi16(
+				    _mm_srli_epi16(p, 11), scale), 7);
+				g = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(
+				    _mm_and_si128(_mm_srli_epi16(p, 8),
+				    _mm_set1_epi16(0x07)), _mm_set1_epi16(259)), 3),
+				    _mm_and_si128(_mm_srli_epi16(p, 3),
+				    _mm_set1_epi16(0x1C)));
+				b = _mm_srli_epi16(_mm_mullo_epi16(
+				    _mm_and_si128(p, _mm_set1_epi16(0x1F)), scale), 7);
+			} else {
+				r = _mm_and_si128(_mm_srli_epi16(p, 8),
+				    _mm_set1_epi16(0xF8));
+				g = _mm_and_si128(_mm_srli_epi16(p, 3),
+				    _mm_set1_epi16(0xFC));
+				b = _mm_and_si128(_mm_slli_epi16(p, 3),
+				    _mm_set1_epi16(0xF8));
+			}
+			if ( swap ) {
+				__m128i t = r; r = b; b = t;
+			}
+			/* Low half of each pixel is B|G<<8, high half R */
+			b = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+			lo = _mm_or_si128(_mm_unpacklo_epi16(b, r), alphav);
+			hi = _mm_or_si128(_mm_unpackhi_epi16(b, r), alphav);
+			_mm_storeu_si128((__m128i *)dst, lo);
+			_mm_storeu_si128((__m128i *)(dst + 4), hi);
+			src += 8;
+			dst += 8;
+		}
+		while ( n-- ) {
+			*dst++ = Pixel_RGB565_32(*src++, swap, alpha);
+		}
+		src = (Uint16 *)((Uint8 *)src + srcskip);
+		dst = (Uint32 *)((Uint8 *)dst + dstskip);
+	}
+}
+
+/* RGB 5-6-5 <-> RGB 5-5-5, 'to565' picks the direction */
+static void Blit_RGB555_565SSE2(SDL_BlitInfo *info, int to565)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	const __m128i rg = _mm_set1_epi16(0x7FE0);
+	const __m128i bl = _mm_set1_epi16(0x001F);
+	int n;
+
+	while ( height-- ) {
+		for ( n = width; n >= 8; n -= 8 ) {
+			__m128i p = _mm_loadu_si128((const __m128i *)src);
+
+			if ( to565 ) {
+				p = _mm_or_si128(
+				    _mm_slli_epi16(_mm_and_si128(p, rg), 1),
+				    _mm_and_si128(p, bl));
+			} else {
+				p = _mm_or_si128(
+				    _mm_and_si128(_mm_srli_epi16(p, 1), rg),
+				    _mm_and_si128(p, bl));
+			}
+			_mm_storeu_si128((__m128i *)dst, p);
+			src += 8;
+			dst += 8;
+		}
+		while ( n-- ) {
+			*dst++ = to565 ? RGB555_RGB565(*src) : RGB565_RGB555(*src);
+			++src;
+		}
+		src = (Uint16 *)((Uint8 *)src + srcskip);
+		dst = (Uint16 *)((Uint8 *)dst + dstskip);
+	}
+}
+static void Blit_RGB555_RGB565SSE2(SDL_BlitInfo *info)
+{
+	Blit_RGB555_565SSE2(info, 1);
+}
+static void Blit_RGB565_RGB555SSE2(SDL_BlitInfo *info)
+{
+	Blit_RGB555_565SSE2(info, 0);
+}
+
+/* Swaps R and B in place, in each 32-bit lane */
+static __inline__ __m128i SwapRB_SSE2(__m128i p)
+{
+	const __m128i lo = _mm_set1_epi32(0x000000FF);
+
+	return _mm_or_si128(_mm_or_si128(
+	           _mm_and_si128(_mm_srli_epi32(p, 16), lo),
+	           _mm_slli_epi32(_mm_and_si128(p, lo), 16)),
+	           _mm_and_si128(p, _mm_set1_epi32(0xFF00FF00)));
+}
+
+static void Blit_24to32SSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int swap = SIMD_SWAP32(info);
+	Uint32 alpha = SIMD_ALPHA(info);
+	const __m128i rgb = _mm_set1_epi32(0x00FFFFFF);
+	const __m128i alphav = _mm_set1_epi32(alpha);
+	int n;
+
+	while ( height-- ) {
+		/* Four pixels are 12 bytes, but we load 16: stop early */
+		for ( n = width; n >= 6; n -= 4 ) {
+			__m128i p = _mm_loadu_si128((const __m128i *)src);
+
+			p = _mm_unpacklo_epi64(
+			    _mm_unpacklo_epi32(p, _mm_srli_si128(p, 3)),
+			    _mm_unpacklo_epi32(_mm_srli_si128(p, 6),
+			                       _mm_srli_si128(p, 9)));
+			p = _mm_and_si128(p, rgb);
+			if ( swap ) {
+				p = SwapRB_SSE2(p);
+			}
+			_mm_storeu_si128((__m128i *)dst, _mm_or_si128(p, alphav));
+			src += 12;
+			dst += 4;
+		}
+		while ( n-- ) {
+			*dst++ = Pixel_24to32(src, swap, alpha);
+			src += 3;
+		}
+		src += srcskip;
+		dst = (Uint32 *)((Uint8 *)dst + dstskip);
+	}
+}
+
+static void Blit_RGB888_RGB565SSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	const __m128i r = _mm_set1_epi32(0x00F80000);
+	const __m128i g = _mm_set1_epi32(0x0000FC00);
+	const __m128i b = _mm_set1_epi32(0x000000F8);
+	__m128i lo, hi;
+	int n;
+
+	while ( height-- ) {
+		for ( n = width; n >= 8; n -= 8 ) {
+			lo = _mm_loadu_si128((const __m128i *)src);
+			hi = _mm_loadu_si128((const __m128i *)(src + 4));
+			lo = _mm_or_si128(_mm_or_si128(
+			    _mm_srli_epi32(_mm_and_si128(lo, r), 8),
+			    _mm_srli_epi32(_mm_and_si128(lo, g), 5)),
+			    _mm_srli_epi32(_mm_and_si128(lo, b), 3));
+			hi = _mm_or_si128(_mm_or_si128(
+			    _mm_srli_epi32(_mm_and_si128(hi, r), 8),
+			    _mm_srli_epi32(_mm_and_si128(hi, g), 5)),
+			    _mm_srli_epi32(_mm_and_si128(hi, b), 3));
+			/* Sign extend, so the signed pack doesn't saturate */
+			lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+			hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+			_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(lo, hi));
+			src += 8;
+			dst += 8;
+		}
+		while ( n-- ) {
+			*dst++ = RGB888_TO_RGB565(*src);
+			++src;
+		}
+		src = (Uint32 *)((Uint8 *)src + srcskip);
+		dst = (Uint16 *)((Uint8 *)dst + dstskip);
+	}
+}
+
+/* xRGB <-> xBGR */
+static void Blit_32to32SwapSSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int copy = (info->src->Amask && info->dst->Amask);
+	Uint32 alpha = SIMD_ALPHA(info);
+	Uint32 keep = copy ? 0xFFFFFFFF : 0x00FFFFFF;
+	const __m128i keepv = _mm_set1_epi32(keep);
+	const __m128i alphav = _mm_set1_epi32(copy ? 0 : alpha);
+	int n;
+
+	if ( copy ) {
+		alpha = 0;
+	}
+	while ( height-- ) {
+		for ( n = width; n >= 8; n -= 8 ) {
+			__m128i lo = _mm_loadu_si128((const __m128i *)src);
+			__m128i hi = _mm_loadu_si128((const __m128i *)(src + 4));
+
+			lo = _mm_or_si128(_mm_and_si128(SwapRB_SSE2(lo), keepv), alphav);
+			hi = _mm_or_si128(_mm_and_si128(SwapRB_SSE2(hi), keepv), alphav);
+			_mm_storeu_si128((__m128i *)dst, lo);
+			_mm_storeu_si128((__m128i *)(dst + 4), hi);
+			src += 8;
+			dst += 8;
+		}
+		while ( n-- ) {
+			*dst++ = (SWAP_RB(*src) & keep) | alpha;
+			++src;
+		}
+		src = (Uint32 *)((Uint8 *)src + srcskip);
+		dst = (Uint32 *)((Uint8 *)dst + dstskip);
+	}
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+#if SDL_NEON_BLITTERS
+SDL_NEON_BEGIN
+static void Blit_RGB565_32NEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int swap = SIMD_SWAP16(info);
+	Uint32 alpha = info->dst->Amask;
+	const uint8x8_t alphav = vdup_n_u8((Uint8)(alpha >> 24));
+	int n;
+
+	while ( height-- ) {
+		for ( n = width; n >= 8; n -= 8 ) {
+			uint16x8_t p = vld1q_u16(src);
+			uint8x8_t r, g, b;
+			uint8x8x4_t out;
+
+			if ( alpha ) {
+				r = vmovn_u16(vshrq_n_u16(vmulq_n_u16(
+				    vshrq_n_u16(p, 11), 1053), 7));
+				g = vmovn_u16(vaddq_u16(vshrq_n_u16(vmulq_n_u16(
+				    vandq_u16(vshrq_n_u16(p, 8), vdupq_n_u16(0x07)),
+				    259), 3),
+				    vandq_u16(vshrq_n_u16(p, 3), vdupq_n_u16(0x1C))));
+				b = vmovn_u16(vshrq_n_u16(vmulq_n_u16(
+				    vandq_u16(p, vdupq_n_u16(0x1F)), 1053), 7));
+			} else {
+				r = vand_u8(vshrn_n_u16(p, 8), vdup_n_u8(0xF8));
+				g = vand_u8(vshrn_n_u16(p, 3), vdup_n_u8(0xFC));
+				b = vshl_n_u8(vmovn_u16(p), 3);
+			}
+			out.val[0] = swap ? r : b;
+			out.val[1] = g;
+			out.val[2] = swap ? b : r;
+			out.val[3] = alphav;
+			vst4_u8((Uint8 *)dst, out);
+			src += 8;
+			dst += 8;
+		}
+		while ( n-- ) {
+			*dst++ = Pixel_RGB565_32(*src++, swap, alpha);
+		}
+		src = (Uint16 *)((Uint8 *)src + srcskip);
+		dst = (Uint32 *)((Uint8 *)dst + dstskip);
+	}
+}
+
+/* RGB 5-6-5 <-> RGB 5-5-5, 'to565' picks the direction */
+static void Blit_RGB555_565NEON(SDL_BlitInfo *info, int to565)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	const uint16x8_t rg = vdupq_n_u16(0x7FE0);
+	const uint16x8_t bl = vdupq_n_u16(0x001F);
+	int n;
+
+	while ( height-- ) {
+		for ( n = width; n >= 8; n -= 8 ) {
+			uint16x8_t p = vld1q_u16(src);
+
+			if ( to565 ) {
+				p = vorrq_u16(vshlq_n_u16(vandq_u16(p, rg), 1),
+				              vandq_u16(p, bl));
+			} else {
+				p = vorrq_u16(vandq_u16(vshrq_n_u16(p, 1), rg),
+				              vandq_u16(p, bl));
+			}
+			vst1q_u16(dst, p);
+			src += 8;
+			dst += 8;
+		}
+		while ( n-- ) {
+			*dst++ = to565 ? RGB555_RGB565(*src) : RGB565_RGB555(*src);
+			++src;
+		}
+		src = (Uint16 *)((Uint8 *)src + srcskip);
+		dst = (Uint16 *)((Uint8 *)dst + dstskip);
+	}
+}
+static void Blit_RGB555_RGB565NEON(SDL_BlitInfo *info)
+{
+	Blit_RGB555_565NEON(info, 1);
+}
+static void Blit_RGB565_RGB555NEON(SDL_BlitInfo *info)
+{
+	Blit_RGB555_565NEON(info, 0);
+}
+
+static void Blit_24to32NEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int swap = SIMD_SWAP32(info);
+	Uint32 alpha = SIMD_ALPHA(info);
+	const uint8x8_t alphav = vdup_n_u8((Uint8)(alpha >> 24));
+	int n;
+
+	while ( height-- ) {
+		for ( n = width; n >= 8; n -= 8 ) {
+			uint8x8x3_t p = vld3_u8(src);
+			uint8x8x4_t out;
+
+			out.val[0] = p.val[swap ? 2 : 0];
+			out.val[1] = p.val[1];
+			out.val[2] = p.val[swap ? 0 : 2];
+			out.val[3] = alphav;
+			vst4_u8((Uint8 *)dst, out);
+			src += 24;
+			dst += 8;
+		}
+		while ( n-- ) {
+			*dst++ = Pixel_24to32(src, swap, alpha);
+			src += 3;
+		}
+		src += srcskip;
+		dst = (Uint32 *)((Uint8 *)dst + dstskip);
+	}
+}
+
+static void Blit_RGB888_RGB565NEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int n;
+
+	while ( height-- ) {
+		for ( n = width; n >= 8; n -= 8 ) {
+			uint8x8x4_t p = vld4_u8((const Uint8 *)src);
+			uint16x8_t out;
+
+			/* Shift-right-and-insert keeps just the top bits */
+			out = vshll_n_u8(p.val[2], 8);
+			out = vsriq_n_u16(out, vshll_n_u8(p.val[1], 8), 5);
+			out = vsriq_n_u16(out, vshll_n_u8(p.val[0], 8), 11);
+			vst1q_u16(dst, out);
+			src += 8;
+			dst += 8;
+		}
+		while ( n-- ) {
+			*dst++ = RGB888_TO_RGB565(*src);
+			++src;
+		}
+		src = (Uint32 *)((Uint8 *)src + srcskip);
+		dst = (Uint16 *)((Uint8 *)dst + dstskip);
+	}
+}
+
+/* xRGB <-> xBGR */
+static void Blit_32to32SwapNEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip;
+	int copy = (info->src->Amask && info->dst->Amask);
+	Uint32 alpha = SIMD_ALPHA(info);
+	Uint32 keep = copy ? 0xFFFFFFFF : 0x00FFFFFF;
+	const uint8x8_t alphav = vdup_n_u8((Uint8)(alpha >> 24));
+	int n;
+
+	if ( copy ) {
+		alpha = 0;
+	}
+	while ( height-- ) {
+		for ( n = width; n >= 8; n -= 8 ) {
+			uint8x8x4_t p = vld4_u8((const Uint8 *)src);
+			uint8x8_t t = p.val[0];
+
+			p.val[0] = p.val[2];
+			p.val[2] = t;
+			if ( ! copy ) {
+				p.val[3] = alphav;
+			}
+			vst4_u8((Uint8 *)dst, p);
+			src += 8;
+			dst += 8;
+		}
+		while ( n-- ) {
+			*dst++ = (SWAP_RB(*src) & keep) | alpha;
+			++src;
+		}
+		src = (Uint32 *)((Uint8 *)src + srcskip);
+		dst = (Uint32 *)((Uint8 *)dst + dstskip);
+	}
+}
+SDL_NEON_END
+#endif /* SDL_NEON_BLITTERS */
+
 /* This is now endian dependent */
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
 #define HI	1
@@ -2284,6 +2805,28 @@ static const struct blit_table normal_blit_1[] = {
 	{ 0,0,0, 0, 0,0,0, 0, NULL, NULL },
 };
 static const struct blit_table normal_blit_2[] = {
+#if SDL_SSE2_BLITTERS
+    /* has-SSE2 */
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      8, NULL, Blit_RGB565_32SSE2, NO_ALPHA | SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      8, NULL, Blit_RGB565_32SSE2, NO_ALPHA | SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 2, 0x00007C00,0x000003E0,0x0000001F,
+      8, NULL, Blit_RGB565_RGB555SSE2, NO_ALPHA },
+    { 0x00007C00,0x000003E0,0x0000001F, 2, 0x0000F800,0x000007E0,0x0000001F,
+      8, NULL, Blit_RGB555_RGB565SSE2, NO_ALPHA },
+#endif
+#if SDL_NEON_BLITTERS
+    /* has-NEON */
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      16, NULL, Blit_RGB565_32NEON, NO_ALPHA | SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      16, NULL, Blit_RGB565_32NEON, NO_ALPHA | SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 2, 0x00007C00,0x000003E0,0x0000001F,
+      16, NULL, Blit_RGB565_RGB555NEON, NO_ALPHA },
+    { 0x00007C00,0x000003E0,0x0000001F, 2, 0x0000F800,0x000007E0,0x0000001F,
+      16, NULL, Blit_RGB555_RGB565NEON, NO_ALPHA },
+#endif
 #if SDL_HERMES_BLITTERS
     { 0x0000F800,0x000007E0,0x0000001F, 2, 0x0000001F,0x000007E0,0x0000F800,
       0, ConvertX86p16_16BGR565, ConvertX86, NO_ALPHA },
@@ -2311,10 +2854,50 @@ static const struct blit_table normal_blit_2[] = {
     { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
 };
 static const struct blit_table normal_blit_3[] = {
-	/* Default for 24-bit RGB source, never optimized */
+#if SDL_SSE2_BLITTERS
+    /* has-SSE2 */
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      8, NULL, Blit_24to32SSE2, NO_ALPHA | SET_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      8, NULL, Blit_24to32SSE2, NO_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      8, NULL, Blit_24to32SSE2, NO_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      8, NULL, Blit_24to32SSE2, NO_ALPHA | SET_ALPHA },
+#endif
+#if SDL_NEON_BLITTERS
+    /* has-NEON */
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      16, NULL, Blit_24to32NEON, NO_ALPHA | SET_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      16, NULL, Blit_24to32NEON, NO_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      16, NULL, Blit_24to32NEON, NO_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      16, NULL, Blit_24to32NEON, NO_ALPHA | SET_ALPHA },
+#endif
+	/* Default for 24-bit RGB source */
     { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
 };
 static const struct blit_table normal_blit_4[] = {
+#if SDL_SSE2_BLITTERS
+    /* has-SSE2 */
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
+      8, NULL, Blit_RGB888_RGB565SSE2, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      8, NULL, Blit_32to32SwapSSE2, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      8, NULL, Blit_32to32SwapSSE2, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
+#if SDL_NEON_BLITTERS
+    /* has-NEON */
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
+      16, NULL, Blit_RGB888_RGB565NEON, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      16, NULL, Blit_32to32SwapNEON, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      16, NULL, Blit_32to32SwapNEON, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
 #if SDL_HERMES_BLITTERS
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
       1, ConvertMMXpII32_16RGB565, ConvertMMX, NO_ALPHA },
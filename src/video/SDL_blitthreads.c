@@ -0,0 +1,213 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Banded software blits.
+
+   Setting SDL_BLIT_THREADS=<n> splits large software blits into n
+   horizontal bands, run by n-1 persistent worker threads and the caller.
+   0 means one band per CPU core.  Each band is a self contained
+   SDL_BlitInfo, so any of the low level blitters can run it.
+*/
+
+#include "SDL_thread.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_blitthreads_c.h"
+
+/* Smaller blits aren't worth waking the workers for */
+#define MIN_THREADED_PIXELS	(64*1024)
+#define MIN_BAND_ROWS		16
+#define MAX_BLIT_THREADS	16
+
+#if !SDL_THREADS_DISABLED
+
+typedef struct {
+	SDL_Thread *thread;
+	SDL_sem *go;
+	SDL_loblit blit;
+	SDL_BlitInfo info;
+} SDL_BlitWorker;
+
+static int blit_threads = -1;		/* not set up yet */
+static int num_workers = 0;
+static SDL_BlitWorker workers[MAX_BLIT_THREADS-1];
+static SDL_sem *blit_done = NULL;
+static SDL_mutex *blit_lock = NULL;
+static int blit_busy = 0;
+static volatile int blit_quit = 0;
+
+static int SDLCALL SDL_BlitWorkerMain(void *data)
+{
+	SDL_BlitWorker *worker = (SDL_BlitWorker *)data;
+
+	for ( ;; ) {
+		SDL_SemWait(worker->go);
+		if ( blit_quit ) {
+			break;
+		}
+		worker->blit(&worker->info);
+		SDL_SemPost(blit_done);
+	}
+	return(0);
+}
+
+static void SDL_BlitThreadsInit(void)
+{
+	const char *env = SDL_getenv("SDL_BLIT_THREADS");
+	int threads = 1;
+
+	if ( env ) {
+		threads = SDL_atoi(env);
+		if ( threads == 0 ) {
+			threads = SDL_GetCPUCount();
+		}
+		if ( threads > MAX_BLIT_THREADS ) {
+			threads = MAX_BLIT_THREADS;
+		}
+	}
+	blit_threads = 1;
+	if ( threads <= 1 ) {
+		return;
+	}
+
+	blit_lock = SDL_CreateMutex();
+	blit_done = SDL_CreateSemaphore(0);
+	if ( !blit_lock || !blit_done ) {
+		SDL_BlitThreadsQuit();
+		blit_threads = 1;
+		return;
+	}
+	for ( num_workers = 0; num_workers < threads-1; ++num_workers ) {
+		SDL_BlitWorker *worker = &workers[num_workers];
+
+		worker->go = SDL_CreateSemaphore(0);
+		if ( worker->go ) {
+			worker->thread = SDL_CreateThread(SDL_BlitWorkerMain, worker);
+		}
+		if ( !worker->go || !worker->thread ) {
+			/* Run with the ones we have */
+			if ( worker->go ) {
+				SDL_DestroySemaphore(worker->go);
+				worker->go = NULL;
+			}
+			break;
+		}
+	}
+	blit_threads = num_workers+1;
+}
+
+int SDL_BlitThreaded(SDL_loblit blit, SDL_BlitInfo *info,
+			int src_pitch, int dst_pitch)
+{
+	int bands, rows, extra, y, i;
+	SDL_BlitInfo band;
+
+	if ( blit_threads < 0 ) {
+		SDL_BlitThreadsInit();
+	}
+	if ( blit_threads <= 1 ||
+	     info->d_width*info->d_height < MIN_THREADED_PIXELS ) {
+		return(0);
+	}
+	bands = info->d_height / MIN_BAND_ROWS;
+	if ( bands > blit_threads ) {
+		bands = blit_threads;
+	}
+	if ( bands <= 1 ) {
+		return(0);
+	}
+
+	/* Another thread is blitting with the workers, go it alone */
+	SDL_mutexP(blit_lock);
+	if ( blit_busy ) {
+		SDL_mutexV(blit_lock);
+		return(0);
+	}
+	blit_busy = 1;
+	SDL_mutexV(blit_lock);
+
+	rows = info->d_height / bands;
+	extra = info->d_height % bands;
+	y = 0;
+	for ( i = 0; i < bands; ++i ) {
+		band = *info;
+		band.s_pixels += y*src_pitch;
+		band.d_pixels += y*dst_pitch;
+		band.s_height = band.d_height = rows + (i < extra);
+		y += band.d_height;
+		if ( i < bands-1 ) {
+			workers[i].blit = blit;
+			workers[i].info = band;
+			SDL_SemPost(workers[i].go);
+		}
+	}
+	/* The last band is ours */
+	blit(&band);
+	for ( i = 0; i < bands-1; ++i ) {
+		SDL_SemWait(blit_done);
+	}
+
+	SDL_mutexP(blit_lock);
+	blit_busy = 0;
+	SDL_mutexV(blit_lock);
+	return(1);
+}
+
+void SDL_BlitThreadsQuit(void)
+{
+	int i;
+
+	blit_quit = 1;
+	for ( i = 0; i < num_workers; ++i ) {
+		SDL_SemPost(workers[i].go);
+		SDL_WaitThread(workers[i].thread, NULL);
+		SDL_DestroySemaphore(workers[i].go);
+		workers[i].go = NULL;
+		workers[i].thread = NULL;
+	}
+	num_workers = 0;
+	blit_quit = 0;
+	if ( blit_done ) {
+		SDL_DestroySemaphore(blit_done);
+		blit_done = NULL;
+	}
+	if ( blit_lock ) {
+		SDL_DestroyMutex(blit_lock);
+		blit_lock = NULL;
+	}
+	blit_busy = 0;
+	blit_threads = -1;
+}
+
+#else
+
+int SDL_BlitThreaded(SDL_loblit blit, SDL_BlitInfo *info,
+			int src_pitch, int dst_pitch)
+{
+	return(0);
+}
+
+void SDL_BlitThreadsQuit(void)
+{
+}
+
+#endif /* !SDL_THREADS_DISABLED */
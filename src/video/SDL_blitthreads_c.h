@@ -0,0 +1,39 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Banded software blits on a pool of worker threads (SDL_BLIT_THREADS) */
+
+#include "SDL_video.h"
+#include "SDL_blit.h"
+
+/* Runs blit over info split into horizontal bands on the blit threads.
+   The pitches are the full row lengths in bytes of the two surfaces.
+   Returns 1 if the blit was done, or 0 if it is too small or threading
+   is off, and the caller should run it as usual.  src and dst must not
+   overlap.
+*/
+extern int SDL_BlitThreaded(SDL_loblit blit, SDL_BlitInfo *info,
+				int src_pitch, int dst_pitch);
+
+/* Stops the worker threads; they are started again on demand */
+extern void SDL_BlitThreadsQuit(void);
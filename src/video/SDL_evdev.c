@@ -0,0 +1,498 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Input from the Linux event devices.
+
+   Every /dev/input/event* node with keys, a relative pointer or an
+   absolute pointer (touchscreen, tablet) is opened, and inotify on
+   /dev/input picks up devices plugged in later.  Each device is read a
+   batch of input_events at a time, and the kernel stamps them with
+   CLOCK_MONOTONIC.  A uinput device works as well as a real one, so this
+   also runs headless.
+*/
+
+#if SDL_INPUT_LINUXEV
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/inotify.h>
+#include <linux/input.h>
+
+#include "SDL_mouse.h"
+#include "../events/SDL_events_c.h"
+#include "SDL_scaling_c.h"
+#include "SDL_evdev_c.h"
+
+/*#define DEBUG_EVDEV*/
+
+#define EVDEV_DIR		"/dev/input"
+#define EVDEV_MAX_DEVICES	32
+#define EVDEV_BATCH		64
+
+#define BITS_PER_LONG		(sizeof(long) * 8)
+#define NBITS(x)		((((x) - 1) / BITS_PER_LONG) + 1)
+#define test_bit(bit, array)	((array[(bit) / BITS_PER_LONG] >> ((bit) % BITS_PER_LONG)) & 1)
+
+typedef struct {
+	int fd;
+	int number;		/* N in /dev/input/eventN */
+	int absolute;		/* Touchscreen or tablet */
+	int abs_min[2];
+	int abs_range[2];
+	int abs_x, abs_y;
+	int abs_moved;
+	int slot;		/* Multitouch slot being reported */
+	int dx, dy;
+	int dropped;		/* Skipping events after a SYN_DROPPED */
+} evdev_device;
+
+static evdev_device devices[EVDEV_MAX_DEVICES];
+static int num_devices = 0;
+static int inotify_fd = -1;
+
+static const SDLKey evdev_keymap[128] = {
+	SDLK_UNKNOWN, SDLK_ESCAPE, SDLK_1, SDLK_2,
+	SDLK_3, SDLK_4, SDLK_5, SDLK_6,
+	SDLK_7, SDLK_8, SDLK_9, SDLK_0,
+	SDLK_MINUS, SDLK_EQUALS, SDLK_BACKSPACE, SDLK_TAB,
+	SDLK_q, SDLK_w, SDLK_e, SDLK_r,
+	SDLK_t, SDLK_y, SDLK_u, SDLK_i,
+	SDLK_o, SDLK_p, SDLK_LEFTBRACKET, SDLK_RIGHTBRACKET,
+	SDLK_RETURN, SDLK_LCTRL, SDLK_a, SDLK_s,
+	SDLK_d, SDLK_f, SDLK_g, SDLK_h,
+	SDLK_j, SDLK_k, SDLK_l, SDLK_SEMICOLON,
+	SDLK_QUOTE, SDLK_BACKQUOTE, SDLK_LSHIFT, SDLK_BACKSLASH,
+	SDLK_z, SDLK_x, SDLK_c, SDLK_v,
+	SDLK_b, SDLK_n, SDLK_m, SDLK_COMMA,
+	SDLK_PERIOD, SDLK_SLASH, SDLK_RSHIFT, SDLK_KP_MULTIPLY,
+	SDLK_LALT, SDLK_SPACE, SDLK_CAPSLOCK, SDLK_F1,
+	SDLK_F2, SDLK_F3, SDLK_F4, SDLK_F5,
+	SDLK_F6, SDLK_F7, SDLK_F8, SDLK_F9,
+	SDLK_F10, SDLK_NUMLOCK, SDLK_SCROLLOCK, SDLK_KP7,
+	SDLK_KP8, SDLK_KP9, SDLK_KP_MINUS, SDLK_KP4,
+	SDLK_KP5, SDLK_KP6, SDLK_KP_PLUS, SDLK_KP1,
+	SDLK_KP2, SDLK_KP3, SDLK_KP0, SDLK_KP_PERIOD,
+	SDLK_UNKNOWN, SDLK_UNKNOWN, SDLK_LESS, SDLK_F11,
+	SDLK_F12, SDLK_UNKNOWN, SDLK_UNKNOWN, SDLK_UNKNOWN,
+	SDLK_UNKNOWN, SDLK_UNKNOWN, SDLK_UNKNOWN, SDLK_UNKNOWN,
+	SDLK_KP_ENTER, SDLK_RCTRL, SDLK_KP_DIVIDE, SDLK_PRINT,
+	SDLK_RALT, SDLK_UNKNOWN, SDLK_HOME, SDLK_UP,
+	SDLK_PAGEUP, SDLK_LEFT, SDLK_RIGHT, SDLK_END,
+	SDLK_DOWN, SDLK_PAGEDOWN, SDLK_INSERT, SDLK_DELETE,
+	SDLK_UNKNOWN, SDLK_UNKNOWN, SDLK_UNKNOWN, SDLK_UNKNOWN,
+	SDLK_POWER, SDLK_KP_EQUALS, SDLK_UNKNOWN, SDLK_PAUSE,
+	SDLK_UNKNOWN, SDLK_UNKNOWN, SDLK_UNKNOWN, SDLK_UNKNOWN,
+	SDLK_UNKNOWN, SDLK_LSUPER, SDLK_RSUPER, SDLK_MENU
+};
+
+SDLKey SDL_EvdevKeysym(int code)
+{
+	if ( code < 0 || code >= SDL_arraysize(evdev_keymap) ) {
+		return(SDLK_UNKNOWN);
+	}
+	return(evdev_keymap[code]);
+}
+
+int SDL_EvdevWanted(void)
+{
+	const char *evdev = SDL_getenv("SDL_INPUT_EVDEV");
+
+	return( evdev && SDL_atoi(evdev) );
+}
+
+static int EvdevFind(int number)
+{
+	int i;
+
+	for ( i = 0; i < num_devices; ++i ) {
+		if ( devices[i].number == number ) {
+			return(i);
+		}
+	}
+	return(-1);
+}
+
+static void EvdevOpen(int number)
+{
+	unsigned long evbit[NBITS(EV_MAX)];
+	unsigned long keybit[NBITS(KEY_MAX)];
+	unsigned long relbit[NBITS(REL_MAX)];
+	unsigned long absbit[NBITS(ABS_MAX)];
+	struct input_absinfo absinfo;
+	evdev_device *device;
+	char path[32];
+	int fd, i, keys, relative, absolute;
+	int clock = CLOCK_MONOTONIC;
+
+	if ( num_devices == EVDEV_MAX_DEVICES || EvdevFind(number) >= 0 ) {
+		return;
+	}
+	SDL_snprintf(path, sizeof(path), EVDEV_DIR "/event%d", number);
+	fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC, 0);
+	if ( fd < 0 ) {
+		return;
+	}
+
+	SDL_memset(evbit, 0, sizeof(evbit));
+	SDL_memset(keybit, 0, sizeof(keybit));
+	SDL_memset(relbit, 0, sizeof(relbit));
+	SDL_memset(absbit, 0, sizeof(absbit));
+	ioctl(fd, EVIOCGBIT(0, sizeof(evbit)), evbit);
+	if ( test_bit(EV_KEY, evbit) ) {
+		ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keybit)), keybit);
+	}
+	if ( test_bit(EV_REL, evbit) ) {
+		ioctl(fd, EVIOCGBIT(EV_REL, sizeof(relbit)), relbit);
+	}
+	if ( test_bit(EV_ABS, evbit) ) {
+		ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absbit)), absbit);
+	}
+
+	/* Joysticks are left to the joystick subsystem */
+	keys = 0;
+	for ( i = KEY_ESC; i < BTN_MISC && !keys; ++i ) {
+		keys = test_bit(i, keybit);
+	}
+	relative = test_bit(REL_X, relbit) && test_bit(REL_Y, relbit);
+	absolute = test_bit(ABS_X, absbit) && test_bit(ABS_Y, absbit) &&
+	           (test_bit(BTN_TOUCH, keybit) || test_bit(BTN_LEFT, keybit));
+	if ( !keys && !relative && !absolute ) {
+		close(fd);
+		return;
+	}
+#ifdef DEBUG_EVDEV
+	fprintf(stderr, "evdev: %s keys %d rel %d abs %d\n",
+		path, keys, relative, absolute);
+#endif
+
+	/* Timestamps on the same clock as the rest of SDL's timing */
+	ioctl(fd, EVIOCSCLOCKID, &clock);
+
+	SDL_AddEventFD(fd, 1);
+	device = &devices[num_devices++];
+	SDL_memset(device, 0, sizeof(*device));
+	device->fd = fd;
+	device->number = number;
+	if ( absolute ) {
+		for ( i = 0; i < 2; ++i ) {
+			if ( ioctl(fd, EVIOCGABS(ABS_X + i), &absinfo) < 0 ||
+			     absinfo.maximum <= absinfo.minimum ) {
+				absolute = 0;
+				break;
+			}
+			device->abs_min[i] = absinfo.minimum;
+			device->abs_range[i] = absinfo.maximum - absinfo.minimum + 1;
+		}
+		device->absolute = absolute;
+	}
+}
+
+static void EvdevClose(int i)
+{
+	SDL_DelEventFD(devices[i].fd, 1);
+	close(devices[i].fd);
+	devices[i] = devices[--num_devices];
+}
+
+/* Handles the creation and removal of /dev/input nodes */
+static void EvdevHotplug(void)
+{
+	char buf[1024];
+	struct inotify_event *event;
+	int nread, pos, number, i;
+
+	while ( (nread = read(inotify_fd, buf, sizeof(buf))) > 0 ) {
+		for ( pos = 0; pos < nread;
+		      pos += sizeof(*event) + event->len ) {
+			event = (struct inotify_event *)&buf[pos];
+			if ( event->len == 0 ||
+			     SDL_sscanf(event->name, "event%d", &number) != 1 ) {
+				continue;
+			}
+			if ( event->mask & (IN_DELETE | IN_MOVED_FROM) ) {
+				i = EvdevFind(number);
+				if ( i >= 0 ) {
+					EvdevClose(i);
+				}
+			} else {
+				/* udev may fix the permissions after creating
+				   the node, so IN_ATTRIB gets another try */
+				EvdevOpen(number);
+			}
+		}
+	}
+}
+
+int SDL_EvdevInit(void)
+{
+	int number;
+
+	num_devices = 0;
+	inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if ( inotify_fd >= 0 &&
+	     inotify_add_watch(inotify_fd, EVDEV_DIR,
+	                       IN_CREATE | IN_ATTRIB | IN_DELETE |
+	                       IN_MOVED_TO | IN_MOVED_FROM) < 0 ) {
+		close(inotify_fd);
+		inotify_fd = -1;
+	}
+	if ( inotify_fd < 0 && access(EVDEV_DIR, R_OK) < 0 ) {
+		SDL_SetError("Couldn't watch " EVDEV_DIR);
+		return(-1);
+	}
+	if ( inotify_fd >= 0 ) {
+		SDL_AddEventFD(inotify_fd, 1);
+	}
+	for ( number = 0; number < 64; ++number ) {
+		EvdevOpen(number);
+	}
+	return(0);
+}
+
+void SDL_EvdevQuit(void)
+{
+	while ( num_devices > 0 ) {
+		EvdevClose(num_devices - 1);
+	}
+	if ( inotify_fd >= 0 ) {
+		SDL_DelEventFD(inotify_fd, 1);
+		close(inotify_fd);
+		inotify_fd = -1;
+	}
+}
+
+static int EvdevButton(int code)
+{
+	switch (code) {
+	    case BTN_LEFT:
+	    case BTN_TOUCH:
+		return(SDL_BUTTON_LEFT);
+	    case BTN_MIDDLE:
+		return(SDL_BUTTON_MIDDLE);
+	    case BTN_RIGHT:
+		return(SDL_BUTTON_RIGHT);
+	    case BTN_SIDE:
+		return(SDL_BUTTON_X1);
+	    case BTN_EXTRA:
+		return(SDL_BUTTON_X2);
+	    default:
+		return(0);
+	}
+}
+
+/* Sends the motion gathered since the last report */
+static int EvdevFlushMotion(evdev_device *device)
+{
+	int posted = 0;
+	int x, y;
+
+	if ( device->dx || device->dy ) {
+		posted += SDL_PrivateMouseMotion(0, 1, device->dx, device->dy);
+		device->dx = 0;
+		device->dy = 0;
+	}
+	if ( device->abs_moved ) {
+		x = (int)(((Sint64)(device->abs_x - device->abs_min[0]) << 16) /
+		          device->abs_range[0]);
+		y = (int)(((Sint64)(device->abs_y - device->abs_min[1]) << 16) /
+		          device->abs_range[1]);
+		SDL_ScalingMapPoint(x, y, &x, &y);
+		posted += SDL_PrivateMouseMotion(0, 0, x, y);
+		device->abs_moved = 0;
+	}
+	return(posted);
+}
+
+/* The kernel's timestamp, CLOCK_MONOTONIC thanks to EVIOCSCLOCKID.
+   Only used when SDL's own clock is CLOCK_MONOTONIC too.
+ */
+#if HAVE_CLOCK_GETTIME
+static Uint32 EvdevTime(const struct input_event *event)
+{
+#ifdef input_event_sec
+	return((Uint32)event->input_event_sec * 1000000 +
+	       (Uint32)event->input_event_usec);
+#else
+	return((Uint32)event->time.tv_sec * 1000000 +
+	       (Uint32)event->time.tv_usec);
+#endif
+}
+#endif /* HAVE_CLOCK_GETTIME */
+
+static int EvdevHandle(SDL_VideoDevice *this, evdev_device *device,
+                       struct input_event *event, SDL_EvdevKeyHandler key)
+{
+	int posted = 0;
+	int button;
+
+#if HAVE_CLOCK_GETTIME
+	SDL_SetEventTimestamp(EvdevTime(event));
+#endif
+
+	if ( device->dropped ) {
+		/* The kernel lost events: wait for the next full report */
+		if ( event->type == EV_SYN && event->code == SYN_REPORT ) {
+			device->dropped = 0;
+		}
+		return(0);
+	}
+
+	switch (event->type) {
+	    case EV_KEY:
+		/* SDL does its own key repeat */
+		if ( event->value == 2 ) {
+			break;
+		}
+		button = EvdevButton(event->code);
+		if ( button ) {
+			/* Press where the pointer is now, not where it was */
+			posted += EvdevFlushMotion(device);
+			posted += SDL_PrivateMouseButton(event->value ?
+				SDL_PRESSED : SDL_RELEASED, button, 0, 0);
+		} else if ( event->code < BTN_MISC ) {
+			posted += key(this, event->code, event->value ?
+				SDL_PRESSED : SDL_RELEASED);
+		}
+		break;
+	    case EV_REL:
+		switch (event->code) {
+		    case REL_X:
+			device->dx += event->value;
+			break;
+		    case REL_Y:
+			device->dy += event->value;
+			break;
+		    case REL_WHEEL:
+			button = (event->value > 0) ?
+				SDL_BUTTON_WHEELUP : SDL_BUTTON_WHEELDOWN;
+			posted += EvdevFlushMotion(device);
+			posted += SDL_PrivateMouseButton(SDL_PRESSED, button, 0, 0);
+			posted += SDL_PrivateMouseButton(SDL_RELEASED, button, 0, 0);
+			break;
+		}
+		break;
+	    case EV_ABS:
+		if ( ! device->absolute ) {
+			break;
+		}
+		/* Multitouch devices: the first slot drives the pointer */
+		switch (event->code) {
+		    case ABS_MT_SLOT:
+			device->slot = event->value;
+			break;
+		    case ABS_X:
+			device->abs_x = event->value;
+			device->abs_moved = 1;
+			break;
+		    case ABS_Y:
+			device->abs_y = event->value;
+			device->abs_moved = 1;
+			break;
+		    case ABS_MT_POSITION_X:
+			if ( device->slot == 0 ) {
+				device->abs_x = event->value;
+				device->abs_moved = 1;
+			}
+			break;
+		    case ABS_MT_POSITION_Y:
+			if ( device->slot == 0 ) {
+				device->abs_y = event->value;
+				device->abs_moved = 1;
+			}
+			break;
+		}
+		break;
+	    case EV_SYN:
+		if ( event->code == SYN_REPORT ) {
+			posted += EvdevFlushMotion(device);
+		} else if ( event->code == SYN_DROPPED ) {
+			device->dx = 0;
+			device->dy = 0;
+			device->abs_moved = 0;
+			device->dropped = 1;
+		}
+		break;
+	}
+	return(posted);
+}
+
+int SDL_EvdevPump(SDL_VideoDevice *this, SDL_EvdevKeyHandler key)
+{
+	struct pollfd fds[EVDEV_MAX_DEVICES + 1];
+	struct input_event events[EVDEV_BATCH];
+	int posted = 0;
+	int i, j, n, nread;
+
+	/* One syscall to find out who has something to say */
+	n = 0;
+	for ( i = 0; i < num_devices; ++i ) {
+		fds[n].fd = devices[i].fd;
+		fds[n].events = POLLIN;
+		++n;
+	}
+	if ( inotify_fd >= 0 ) {
+		fds[n].fd = inotify_fd;
+		fds[n].events = POLLIN;
+		++n;
+	}
+	if ( n == 0 || poll(fds, n, 0) <= 0 ) {
+		return(0);
+	}
+
+	for ( i = num_devices - 1; i >= 0; --i ) {
+		if ( !(fds[i].revents & (POLLIN | POLLERR | POLLHUP)) ) {
+			continue;
+		}
+		for ( ;; ) {
+			nread = read(devices[i].fd, events, sizeof(events));
+			if ( nread < 0 && errno == ENODEV ) {
+				/* Unplugged */
+				EvdevClose(i);
+				break;
+			}
+			if ( nread < (int)sizeof(events[0]) ) {
+				break;
+			}
+			nread /= sizeof(events[0]);
+			for ( j = 0; j < nread; ++j ) {
+				posted += EvdevHandle(this, &devices[i],
+				                      &events[j], key);
+			}
+			if ( nread < EVDEV_BATCH ) {
+				break;
+			}
+		}
+	}
+	SDL_SetEventTimestamp(0);
+	if ( inotify_fd >= 0 && (fds[n-1].revents & POLLIN) ) {
+		EvdevHotplug();
+	}
+	return(posted);
+}
+
+#endif /* SDL_INPUT_LINUXEV */
@@ -0,0 +1,50 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Linux evdev input (/dev/input/event*), shared by the console drivers */
+
+#include "SDL_keysym.h"
+#include "SDL_sysvideo.h"
+
+/* Gets a Linux key code (KEY_*) from a keyboard, returns events posted */
+typedef int (*SDL_EvdevKeyHandler)(SDL_VideoDevice *this, int code, int pressed);
+
+/* A US layout translation for Linux key codes, for when there is no
+   console keymap to go by
+*/
+extern SDLKey SDL_EvdevKeysym(int code);
+
+/* Non-zero if SDL_INPUT_EVDEV asks for evdev input */
+extern int SDL_EvdevWanted(void);
+
+/* Opens the input devices and starts watching /dev/input for new ones.
+   Returns 0, or -1 if /dev/input can't be used.
+*/
+extern int SDL_EvdevInit(void);
+extern void SDL_EvdevQuit(void);
+
+/* Reads everything the devices have queued, without blocking, posting
+   mouse and touch events and handing keys to 'key'.  Returns the number
+   of events posted.
+*/
+extern int SDL_EvdevPump(SDL_VideoDevice *this, SDL_EvdevKeyHandler key);
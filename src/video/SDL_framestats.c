@@ -0,0 +1,161 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Frame pacing statistics.
+
+   Setting SDL_VIDEO_FRAME_STATS=<n> prints a summary to stderr every
+   n frames, so pacing can be checked in the field without a profiler.
+
+   Drivers that get flip completions on a callback thread report them
+   from there, so the counters are kept under a lock.
+*/
+
+#include <stdio.h>
+#if HAVE_CLOCK_GETTIME
+#include <time.h>
+#endif
+
+#include "SDL_timer.h"
+#include "SDL_mutex.h"
+#include "SDL_framestats_c.h"
+
+static int stats_enabled = 0;
+static int stats_interval = 0;
+static SDL_FrameStats stats;
+static double latency_total;
+static Uint32 last_sequence;
+static Uint32 copy_usec;
+static Uint32 wait_usec;
+static SDL_mutex *stats_lock = NULL;
+
+#define LOCK_STATS()	if ( stats_lock ) SDL_mutexP(stats_lock)
+#define UNLOCK_STATS()	if ( stats_lock ) SDL_mutexV(stats_lock)
+
+void SDL_FrameStatsInit(void)
+{
+	const char *interval;
+
+	if ( ! stats_lock ) {
+		stats_lock = SDL_CreateMutex();
+	}
+	LOCK_STATS();
+	SDL_memset(&stats, 0, sizeof(stats));
+	latency_total = 0.0;
+	last_sequence = 0;
+	copy_usec = 0;
+	wait_usec = 0;
+
+	interval = SDL_getenv("SDL_VIDEO_FRAME_STATS");
+	stats_interval = interval ? SDL_atoi(interval) : 0;
+	stats_enabled = 1;
+	UNLOCK_STATS();
+}
+
+void SDL_FrameStatsQuit(void)
+{
+	stats_enabled = 0;
+	if ( stats_lock ) {
+		SDL_DestroyMutex(stats_lock);
+		stats_lock = NULL;
+	}
+}
+
+Uint32 SDL_FrameStatsNow(void)
+{
+#if HAVE_CLOCK_GETTIME
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((Uint32)now.tv_sec * 1000000 + (Uint32)(now.tv_nsec / 1000));
+#else
+	return(SDL_GetTicks() * 1000);
+#endif
+}
+
+void SDL_FrameStatsFlip(Uint32 when, Uint32 latency, Uint32 sequence)
+{
+	SDL_FrameStats now;
+
+	if ( ! stats_enabled ) {
+		return;
+	}
+
+	LOCK_STATS();
+	++stats.frames;
+	stats.flip_time = when;
+	if ( sequence ) {
+		if ( last_sequence && (sequence - last_sequence) > 1 ) {
+			stats.missed_vblanks += (sequence - last_sequence) - 1;
+		}
+		last_sequence = sequence;
+		stats.sequence = sequence;
+	}
+	stats.last_latency = latency;
+	if ( latency > stats.max_latency ) {
+		stats.max_latency = latency;
+	}
+	latency_total += latency;
+	stats.avg_latency = (Uint32)(latency_total / stats.frames);
+	now = stats;
+	UNLOCK_STATS();
+
+	if ( stats_interval > 0 && (now.frames % stats_interval) == 0 ) {
+		fprintf(stderr,
+			"SDL frame stats: %u frames, vblank %u, %u missed, "
+			"latency %u/%u/%u us (last/avg/max), "
+			"copy %u ms, wait %u ms\n",
+			now.frames, now.sequence, now.missed_vblanks,
+			now.last_latency, now.avg_latency, now.max_latency,
+			now.copy_time, now.wait_time);
+	}
+}
+
+void SDL_FrameStatsCopy(Uint32 usec)
+{
+	LOCK_STATS();
+	copy_usec += usec;
+	stats.copy_time += copy_usec / 1000;
+	copy_usec %= 1000;
+	UNLOCK_STATS();
+}
+
+void SDL_FrameStatsWait(Uint32 usec)
+{
+	LOCK_STATS();
+	wait_usec += usec;
+	stats.wait_time += wait_usec / 1000;
+	wait_usec %= 1000;
+	UNLOCK_STATS();
+}
+
+int SDL_GetFrameStats(SDL_FrameStats *frame_stats)
+{
+	if ( ! stats_enabled ) {
+		SDL_SetError("Frame statistics not supported by this video driver");
+		return(-1);
+	}
+	LOCK_STATS();
+	*frame_stats = stats;
+	UNLOCK_STATS();
+	return(0);
+}
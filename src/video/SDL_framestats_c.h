@@ -0,0 +1,44 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Bookkeeping behind SDL_GetFrameStats(), fed by the video drivers */
+
+#include "SDL_video.h"
+
+/* Called by a driver that reports statistics, from its VideoInit */
+extern void SDL_FrameStatsInit(void);
+extern void SDL_FrameStatsQuit(void);
+
+/* A monotonic clock in microseconds; it wraps, so only use differences */
+extern Uint32 SDL_FrameStatsNow(void);
+
+/* A frame reached the screen at 'when' (SDL_FrameStatsNow() time).
+   latency is the time from the application handing it over to the flip,
+   in microseconds.  sequence is the vblank counter at the flip, or 0 if
+   the driver doesn't know it.
+*/
+extern void SDL_FrameStatsFlip(Uint32 when, Uint32 latency, Uint32 sequence);
+
+/* Time spent copying pixels or blocked on the display, in microseconds */
+extern void SDL_FrameStatsCopy(Uint32 usec);
+extern void SDL_FrameStatsWait(Uint32 usec);
@@ -0,0 +1,155 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Hardware scaling policies.
+
+   SDL_VIDEO_SCALING=aspect|integer|stretch|crop picks how the video
+   surface is laid out on the display plane, so that pixel perfect or
+   aspect correct scaling costs no CPU time.
+*/
+
+#include <stdio.h>
+
+#include "SDL_sysvideo.h"
+#include "SDL_scaling_c.h"
+
+static int scaling_valid = 0;
+static SDL_Rect scaling_src;
+static SDL_Rect scaling_dst;
+static int display_w, display_h;
+
+int SDL_GetScalingPolicy(int default_policy)
+{
+	const char *policy = SDL_getenv("SDL_VIDEO_SCALING");
+
+	if ( policy == NULL ) {
+		return(default_policy);
+	}
+	if ( SDL_strcasecmp(policy, "aspect") == 0 ) {
+		return(SDL_SCALE_ASPECT);
+	}
+	if ( SDL_strcasecmp(policy, "integer") == 0 ) {
+		return(SDL_SCALE_INTEGER);
+	}
+	if ( SDL_strcasecmp(policy, "stretch") == 0 ) {
+		return(SDL_SCALE_STRETCH);
+	}
+	if ( SDL_strcasecmp(policy, "crop") == 0 ) {
+		return(SDL_SCALE_CROP);
+	}
+	fprintf(stderr, "SDL_VIDEO_SCALING: unknown policy '%s'\n", policy);
+	return(default_policy);
+}
+
+void SDL_ComputeScaling(int policy, int src_w, int src_h,
+				int dst_w, int dst_h, SDL_Rect *src, SDL_Rect *dst)
+{
+	int w, h, factor;
+
+	src->x = 0;
+	src->y = 0;
+	src->w = src_w;
+	src->h = src_h;
+	w = dst_w;
+	h = dst_h;
+
+	switch (policy) {
+	    case SDL_SCALE_INTEGER:
+		factor = dst_w / src_w;
+		if ( dst_h / src_h < factor ) {
+			factor = dst_h / src_h;
+		}
+		if ( factor > 0 ) {
+			w = src_w * factor;
+			h = src_h * factor;
+			break;
+		}
+		/* The surface is bigger than the display: keep the aspect */
+		/* fall through */
+	    case SDL_SCALE_ASPECT:
+		if ( src_w * dst_h > dst_w * src_h ) {
+			h = (src_h * dst_w) / src_w;
+		} else {
+			w = (src_w * dst_h) / src_h;
+		}
+		break;
+	    case SDL_SCALE_CROP:
+		if ( src_w * dst_h > dst_w * src_h ) {
+			src->w = (dst_w * src_h) / dst_h;
+			src->x = (src_w - src->w) / 2;
+		} else {
+			src->h = (dst_h * src_w) / dst_w;
+			src->y = (src_h - src->h) / 2;
+		}
+		break;
+	    default:
+		break;
+	}
+	dst->x = (dst_w - w) / 2;
+	dst->y = (dst_h - h) / 2;
+	dst->w = w;
+	dst->h = h;
+
+	scaling_src = *src;
+	scaling_dst = *dst;
+	display_w = dst_w;
+	display_h = dst_h;
+	scaling_valid = 1;
+}
+
+void SDL_ScalingMapPoint(int fx, int fy, int *x, int *y)
+{
+	if ( ! scaling_valid ) {
+		/* The surface covers the whole display */
+		*x = *y = 0;
+		if ( SDL_VideoSurface ) {
+			*x = (fx * SDL_VideoSurface->w) >> 16;
+			*y = (fy * SDL_VideoSurface->h) >> 16;
+		}
+		return;
+	}
+	*x = ((fx * display_w) >> 16) - scaling_dst.x;
+	*y = ((fy * display_h) >> 16) - scaling_dst.y;
+	*x = scaling_src.x + (*x * scaling_src.w) / scaling_dst.w;
+	*y = scaling_src.y + (*y * scaling_src.h) / scaling_dst.h;
+}
+
+void SDL_ScalingQuit(void)
+{
+	scaling_valid = 0;
+}
+
+int SDL_GetVideoScaling(SDL_Rect *src, SDL_Rect *dst)
+{
+	if ( ! scaling_valid ) {
+		SDL_SetError("The video driver doesn't scale the display");
+		return(-1);
+	}
+	if ( src ) {
+		*src = scaling_src;
+	}
+	if ( dst ) {
+		*dst = scaling_dst;
+	}
+	return(0);
+}
@@ -0,0 +1,48 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Scaling policies for drivers that scale the video surface in hardware */
+
+#include "SDL_video.h"
+
+#define SDL_SCALE_ASPECT	0	/* Largest rect with the surface's aspect */
+#define SDL_SCALE_INTEGER	1	/* Largest whole multiple of the surface */
+#define SDL_SCALE_STRETCH	2	/* The whole display */
+#define SDL_SCALE_CROP		3	/* Fill the display, cropping the surface */
+
+/* Returns the policy set with SDL_VIDEO_SCALING, or default_policy */
+extern int SDL_GetScalingPolicy(int default_policy);
+
+/* Works out which part of a src_w x src_h surface is shown (src) and where
+   it goes on a dst_w x dst_h display (dst), and remembers both for
+   SDL_GetVideoScaling().  Call it once per mode set.
+*/
+extern void SDL_ComputeScaling(int policy, int src_w, int src_h,
+				int dst_w, int dst_h, SDL_Rect *src, SDL_Rect *dst);
+
+/* Maps a point on the display, given as a 16.16 fraction of its width and
+   height, to video surface coordinates.  Used for absolute pointers.
+*/
+extern void SDL_ScalingMapPoint(int fx, int fy, int *x, int *y);
+
+extern void SDL_ScalingQuit(void);
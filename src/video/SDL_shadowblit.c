@@ -0,0 +1,223 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Shadow buffer to video memory copy kernels.
+
+   Video memory is usually mapped write-combined: reads are very slow and
+   writes are only fast when they fill whole bursts.  The straight copy
+   never reads from the destination and, where the CPU allows it, writes
+   16 bytes at a time with stores that bypass the cache so the copy does
+   not evict the shadow buffer the application is drawing into.
+*/
+
+#include "SDL_shadowblit_c.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_blit.h"
+
+typedef void SDL_ShadowCopyFunc(const Uint8 *src, int src_pitch,
+		Uint8 *dst, int dst_pitch, int len, int height);
+
+static void SDL_ShadowCopyRowsC(const Uint8 *src, int src_pitch,
+		Uint8 *dst, int dst_pitch, int len, int height)
+{
+	while (height--) {
+		SDL_memcpy(dst, src, len);
+		src += src_pitch;
+		dst += dst_pitch;
+	}
+}
+
+#if SDL_SSE2_BLITTERS
+static void SDL_ShadowCopyRowsSSE2(const Uint8 *src, int src_pitch,
+		Uint8 *dst, int dst_pitch, int len, int height)
+{
+	while (height--) {
+		const Uint8 *s = src;
+		Uint8 *d = dst;
+		int n = len;
+
+		if (n >= 64) {
+			/* Streaming stores need an aligned destination */
+			int head = (int)((16 - ((size_t)d & 15)) & 15);
+			if (head) {
+				SDL_memcpy(d, s, head);
+				d += head;
+				s += head;
+				n -= head;
+			}
+			while (n >= 64) {
+				__m128i a = _mm_loadu_si128((const __m128i *)s);
+				__m128i b = _mm_loadu_si128((const __m128i *)(s + 16));
+				__m128i c = _mm_loadu_si128((const __m128i *)(s + 32));
+				__m128i e = _mm_loadu_si128((const __m128i *)(s + 48));
+				_mm_stream_si128((__m128i *)d, a);
+				_mm_stream_si128((__m128i *)(d + 16), b);
+				_mm_stream_si128((__m128i *)(d + 32), c);
+				_mm_stream_si128((__m128i *)(d + 48), e);
+				s += 64;
+				d += 64;
+				n -= 64;
+			}
+		}
+		if (n) {
+			SDL_memcpy(d, s, n);
+		}
+		src += src_pitch;
+		dst += dst_pitch;
+	}
+	/* Make the streamed data visible before the buffer is scanned out */
+	_mm_sfence();
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+#if SDL_NEON_BLITTERS
+SDL_NEON_BEGIN
+static void SDL_ShadowCopyRowsNEON(const Uint8 *src, int src_pitch,
+		Uint8 *dst, int dst_pitch, int len, int height)
+{
+	while (height--) {
+		const Uint8 *s = src;
+		Uint8 *d = dst;
+		int n = len;
+
+		while (n >= 64) {
+			uint8x16_t a = vld1q_u8(s);
+			uint8x16_t b = vld1q_u8(s + 16);
+			uint8x16_t c = vld1q_u8(s + 32);
+			uint8x16_t e = vld1q_u8(s + 48);
+			vst1q_u8(d, a);
+			vst1q_u8(d + 16, b);
+			vst1q_u8(d + 32, c);
+			vst1q_u8(d + 48, e);
+			s += 64;
+			d += 64;
+			n -= 64;
+		}
+		if (n) {
+			SDL_memcpy(d, s, n);
+		}
+		src += src_pitch;
+		dst += dst_pitch;
+	}
+}
+SDL_NEON_END
+#endif /* SDL_NEON_BLITTERS */
+
+/* Chosen by SDL_GetShadowBlit() from what the CPU supports */
+static SDL_ShadowCopyFunc *SDL_ShadowCopyRows = SDL_ShadowCopyRowsC;
+
+#define COPY_PIXEL1(dst, src)	*(dst) = *(src)
+#define COPY_PIXEL2(dst, src)	*(Uint16 *)(dst) = *(Uint16 *)(src)
+#define COPY_PIXEL3(dst, src)	\
+	{ (dst)[0] = (src)[0]; (dst)[1] = (src)[1]; (dst)[2] = (src)[2]; }
+#define COPY_PIXEL4(dst, src)	*(Uint32 *)(dst) = *(Uint32 *)(src)
+
+#define BLOCKSIZE_W 32
+#define BLOCKSIZE_H 32
+
+#define SHADOW_KERNELS(bpp)						\
+static void SDL_ShadowCopy##bpp(Uint8 *src_pos, int src_right_delta,	\
+		int src_down_delta, Uint8 *dst_pos, int dst_linebytes,	\
+		int width, int height)					\
+{									\
+	SDL_ShadowCopyRows(src_pos, src_down_delta * bpp,		\
+			dst_pos, dst_linebytes, width * bpp, height);	\
+}									\
+									\
+static void SDL_ShadowStrided##bpp(Uint8 *src_pos, int src_right_delta,	\
+		int src_down_delta, Uint8 *dst_pos, int dst_linebytes,	\
+		int width, int height)					\
+{									\
+	int w;								\
+									\
+	while (height) {						\
+		Uint8 *src = src_pos;					\
+		Uint8 *dst = dst_pos;					\
+		for (w = width; w != 0; w--) {				\
+			COPY_PIXEL##bpp(dst, src);			\
+			src += src_right_delta * bpp;			\
+			dst += bpp;					\
+		}							\
+		dst_pos += dst_linebytes;				\
+		src_pos += src_down_delta * bpp;			\
+		height--;						\
+	}								\
+}									\
+									\
+static void SDL_ShadowBlocked##bpp(Uint8 *src_pos, int src_right_delta,	\
+		int src_down_delta, Uint8 *dst_pos, int dst_linebytes,	\
+		int width, int height)					\
+{									\
+	int w;								\
+									\
+	while (height > 0) {						\
+		Uint8 *src = src_pos;					\
+		Uint8 *dst = dst_pos;					\
+		for (w = width; w > 0; w -= BLOCKSIZE_W) {		\
+			SDL_ShadowStrided##bpp(src,			\
+				src_right_delta,			\
+				src_down_delta,				\
+				dst,					\
+				dst_linebytes,				\
+				w < BLOCKSIZE_W ? w : BLOCKSIZE_W,	\
+				height < BLOCKSIZE_H ? height : BLOCKSIZE_H); \
+			src += src_right_delta * bpp * BLOCKSIZE_W;	\
+			dst += bpp * BLOCKSIZE_W;			\
+		}							\
+		dst_pos += dst_linebytes * BLOCKSIZE_H;			\
+		src_pos += src_down_delta * bpp * BLOCKSIZE_H;		\
+		height -= BLOCKSIZE_H;					\
+	}								\
+}
+
+SHADOW_KERNELS(1)
+SHADOW_KERNELS(2)
+SHADOW_KERNELS(3)
+SHADOW_KERNELS(4)
+
+static SDL_ShadowBlit *shadow_blits[4][3] = {
+	{ SDL_ShadowCopy1, SDL_ShadowStrided1, SDL_ShadowBlocked1 },
+	{ SDL_ShadowCopy2, SDL_ShadowStrided2, SDL_ShadowBlocked2 },
+	{ SDL_ShadowCopy3, SDL_ShadowStrided3, SDL_ShadowBlocked3 },
+	{ SDL_ShadowCopy4, SDL_ShadowStrided4, SDL_ShadowBlocked4 }
+};
+
+SDL_ShadowBlit *SDL_GetShadowBlit(int bytes_per_pixel, int layout)
+{
+	if ( bytes_per_pixel < 1 || bytes_per_pixel > 4 ||
+	     layout < SDL_SHADOW_COPY || layout > SDL_SHADOW_BLOCKED ) {
+		return(NULL);
+	}
+	SDL_ShadowCopyRows = SDL_ShadowCopyRowsC;
+#if SDL_SSE2_BLITTERS
+	if ( SDL_HasSSE2() ) {
+		SDL_ShadowCopyRows = SDL_ShadowCopyRowsSSE2;
+	}
+#endif
+#if SDL_NEON_BLITTERS
+	if ( SDL_HasNEON() ) {
+		SDL_ShadowCopyRows = SDL_ShadowCopyRowsNEON;
+	}
+#endif
+	return(shadow_blits[bytes_per_pixel-1][layout]);
+}
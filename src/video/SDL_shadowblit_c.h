@@ -0,0 +1,48 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Copy kernels for drivers that render into a shadow buffer in system
+   memory and then push it out to (uncached, write-combined) video memory.
+*/
+
+#include "SDL_video.h"
+
+typedef void SDL_ShadowBlit(
+		Uint8 *src_pos,
+		int src_right_delta,	/* pixels, not bytes */
+		int src_down_delta,	/* pixels, not bytes */
+		Uint8 *dst_pos,
+		int dst_linebytes,
+		int width,
+		int height);
+
+/* How the shadow is laid out relative to the screen */
+#define SDL_SHADOW_COPY		0	/* src_right_delta is 1: plain row copies */
+#define SDL_SHADOW_STRIDED	1	/* arbitrary deltas, walked row by row */
+#define SDL_SHADOW_BLOCKED	2	/* arbitrary deltas, walked in cache sized tiles */
+
+/* Returns the kernel for the given pixel size and layout, or NULL if
+   there is none for that pixel size.  The row copy is chosen here from
+   the CPU features, so call it when the video mode is set.
+*/
+extern SDL_ShadowBlit *SDL_GetShadowBlit(int bytes_per_pixel, int layout);
@@ -22,6 +22,7 @@
 #include "SDL_config.h"
 
 #include "SDL_video.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_sysvideo.h"
 #include "SDL_cursor_c.h"
 #include "SDL_blit.h"
@@ -547,6 +548,100 @@ static int SDL_FillRect4(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	return -1;
 }
 
+/* How SDL_FillRect() may write the pixels, chosen per call */
+#define SDL_FILL_SIMD	0x01	/* the CPU has the vector unit we built for */
+#define SDL_FILL_STREAM	0x02	/* bypass the cache (video memory) */
+
+#if SDL_SSE2_BLITTERS
+/* Fill 'blocks' runs of 16 words at the 16-byte aligned 'd' */
+static void SDL_FillBlocksSSE2(Uint32 *d, int blocks, Uint32 cc, int stream)
+{
+	__m128i c4 = _mm_set1_epi32((int)cc);
+
+	if ( stream ) {
+		while ( blocks-- ) {
+			_mm_stream_si128((__m128i *)d, c4);
+			_mm_stream_si128((__m128i *)(d + 4), c4);
+			_mm_stream_si128((__m128i *)(d + 8), c4);
+			_mm_stream_si128((__m128i *)(d + 12), c4);
+			d += 16;
+		}
+	} else {
+		while ( blocks-- ) {
+			_mm_store_si128((__m128i *)d, c4);
+			_mm_store_si128((__m128i *)(d + 4), c4);
+			_mm_store_si128((__m128i *)(d + 8), c4);
+			_mm_store_si128((__m128i *)(d + 12), c4);
+			d += 16;
+		}
+	}
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+#if SDL_NEON_BLITTERS
+SDL_NEON_BEGIN
+/* Fill 'blocks' runs of 16 words at the 16-byte aligned 'd' */
+static void SDL_FillBlocksNEON(Uint32 *d, int blocks, Uint32 cc)
+{
+	uint32x4_t c4 = vdupq_n_u32(cc);
+
+	while ( blocks-- ) {
+		vst1q_u32(d, c4);
+		vst1q_u32(d + 4, c4);
+		vst1q_u32(d + 8, c4);
+		vst1q_u32(d + 12, c4);
+		d += 16;
+	}
+}
+SDL_NEON_END
+#endif /* SDL_NEON_BLITTERS */
+
+/*
+ * Fill 'n' 32-bit words at the 4-byte aligned 'd' with 'cc'.
+ * With SDL_FILL_SIMD set, long runs are written with aligned 16-byte
+ * vector stores.  Video memory is usually mapped write-combined, so with
+ * SDL_FILL_STREAM set the SSE2 kernel uses non-temporal stores that go
+ * straight out in full bursts instead of pulling the framebuffer through
+ * the cache.
+ */
+static void SDL_FillWords(Uint32 *d, int n, Uint32 cc, int fill)
+{
+	if ( (fill & SDL_FILL_SIMD) && (n >= 16) && !((uintptr_t)d & 3) ) {
+		while ( (uintptr_t)d & 15 ) {
+			*d++ = cc;
+			--n;
+		}
+#if SDL_SSE2_BLITTERS
+		SDL_FillBlocksSSE2(d, n >> 4, cc, (fill & SDL_FILL_STREAM));
+#elif SDL_NEON_BLITTERS
+		SDL_FillBlocksNEON(d, n >> 4, cc);
+#endif
+		d += n & ~15;
+		n &= 15;
+	}
+	if ( n ) {
+		SDL_memset4(d, cc, n);
+	}
+}
+
+/* Fill 'len' bytes with the low byte of 'color' */
+static void SDL_FillBytes(Uint8 *d, int len, Uint32 color, int fill)
+{
+	Uint8 c = (Uint8)color;
+
+	while ( len && ((uintptr_t)d & 3) ) {
+		*d++ = c;
+		--len;
+	}
+	if ( len >> 2 ) {
+		SDL_FillWords((Uint32 *)d, len >> 2, c * 0x01010101, fill);
+		d += len & ~3;
+	}
+	for ( len &= 3; len; --len ) {
+		*d++ = c;
+	}
+}
+
 /* 
  * This function performs a fast fill of the given rectangle with 'color'
  */
@@ -554,7 +649,7 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 {
 	SDL_VideoDevice *video = current_video;
 	SDL_VideoDevice *this  = current_video;
-	int x, y;
+	int x, y, w, h, fill;
 	Uint8 *row;
 
 	/* This function doesn't work on surfaces < 8 bpp */
@@ -602,12 +697,33 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	}
 	row = (Uint8 *)dst->pixels+dstrect->y*dst->pitch+
 			dstrect->x*dst->format->BytesPerPixel;
+	fill = 0;
+#if SDL_SSE2_BLITTERS
+	if ( SDL_HasSSE2() ) {
+		fill = SDL_FILL_SIMD;
+		if ( (dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE ) {
+			fill |= SDL_FILL_STREAM;
+		}
+	}
+#elif SDL_NEON_BLITTERS
+	if ( SDL_HasNEON() ) {
+		fill = SDL_FILL_SIMD;
+	}
+#endif
+	w = dstrect->w;
+	h = dstrect->h;
+	if ( (w > 0) && (dst->pitch == w*dst->format->BytesPerPixel) &&
+	     (h <= 0x7FFFFFFF / dst->pitch) ) {
+		/* The rectangle spans whole rows, fill it as one long row */
+		w *= h;
+		h = 1;
+	}
 	if ( dst->format->palette || (color == 0) ) {
-		x = dstrect->w*dst->format->BytesPerPixel;
+		x = w*dst->format->BytesPerPixel;
 		if ( !color && !((uintptr_t)row&3) && !(x&3) && !(dst->pitch&3) ) {
 			int n = x >> 2;
-			for ( y=dstrect->h; y; --y ) {
-				SDL_memset4(row, 0, n);
+			for ( y=h; y; --y ) {
+				SDL_FillWords((Uint32 *)row, n, 0, fill);
 				row += dst->pitch;
 			}
 		} else {
@@ -619,14 +735,14 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			 * uncachable, so only use it on software surfaces
 			 */
 			if((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) {
-				if(dstrect->w >= 8) {
+				if(w >= 8) {
 					/*
 					 * 64-bit stores are probably most
 					 * efficient to uncached video memory
 					 */
 					double fill;
 					SDL_memset(&fill, color, (sizeof fill));
-					for(y = dstrect->h; y; y--) {
+					for(y = h; y; y--) {
 						Uint8 *d = row;
 						unsigned n = x;
 						unsigned nn;
@@ -662,7 +778,7 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 					}
 				} else {
 					/* narrow boxes */
-					for(y = dstrect->h; y; y--) {
+					for(y = h; y; y--) {
 						Uint8 *d = row;
 						Uint8 c = color;
 						int n = x;
@@ -676,8 +792,8 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			} else
 #endif /* __powerpc__ */
 			{
-				for(y = dstrect->h; y; y--) {
-					SDL_memset(row, color, x);
+				for(y = h; y; y--) {
+					SDL_FillBytes(row, x, color, fill);
 					row += dst->pitch;
 				}
 			}
@@ -685,17 +801,18 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	} else {
 		switch (dst->format->BytesPerPixel) {
 		    case 2:
-			for ( y=dstrect->h; y; --y ) {
+			for ( y=h; y; --y ) {
 				Uint16 *pixels = (Uint16 *)row;
 				Uint16 c = (Uint16)color;
 				Uint32 cc = (Uint32)c << 16 | c;
-				int n = dstrect->w;
+				int n = w;
 				if((uintptr_t)pixels & 3) {
 					*pixels++ = c;
 					n--;
 				}
 				if(n >> 1)
-					SDL_memset4(pixels, cc, n >> 1);
+					SDL_FillWords((Uint32 *)pixels, n >> 1,
+								cc, fill);
 				if(n & 1)
 					pixels[n - 1] = c;
 				row += dst->pitch;
@@ -706,9 +823,9 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			#if SDL_BYTEORDER == SDL_BIG_ENDIAN
 				color <<= 8;
 			#endif
-			for ( y=dstrect->h; y; --y ) {
+			for ( y=h; y; --y ) {
 				Uint8 *pixels = row;
-				for ( x=dstrect->w; x; --x ) {
+				for ( x=w; x; --x ) {
 					SDL_memcpy(pixels, &color, 3);
 					pixels += 3;
 				}
@@ -717,13 +834,19 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			break;
 
 		    case 4:
-			for(y = dstrect->h; y; --y) {
-				SDL_memset4(row, color, dstrect->w);
+			for(y = h; y; --y) {
+				SDL_FillWords((Uint32 *)row, w, color, fill);
 				row += dst->pitch;
 			}
 			break;
 		}
 	}
+#if SDL_SSE2_BLITTERS
+	if ( fill & SDL_FILL_STREAM ) {
+		/* Drain the write-combining buffers before the surface is used */
+		_mm_sfence();
+	}
+#endif
 	SDL_UnlockSurface(dst);
 
 	/* We're done! */
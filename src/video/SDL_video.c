@@ -26,8 +26,11 @@
 #include "SDL.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
+#include "SDL_blitthreads_c.h"
 #include "SDL_pixels_c.h"
 #include "SDL_cursor_c.h"
+#include "SDL_framestats_c.h"
+#include "SDL_scaling_c.h"
 #include "../events/SDL_sysevents.h"
 #include "../events/SDL_events_c.h"
 
@@ -1145,6 +1148,9 @@ void SDL_VideoQuit (void)
 
 		/* Clean up the system video */
 		video->VideoQuit(this);
+		SDL_FrameStatsQuit();
+		SDL_ScalingQuit();
+		SDL_BlitThreadsQuit();
 
 		/* Free any lingering surfaces */
 		ready_to_go = SDL_ShadowSurface;
@@ -18,6 +18,9 @@
 #include <string.h>
 #include <errno.h>
 #include <bcm_host.h>
+#if SDL_VIDEO_DRIVER_DISPMANX_VCSM
+#include <interface/vcsm/user-vcsm.h>
+#endif
 //
 
 #ifndef HAVE_GETPAGESIZE
@@ -28,8 +31,13 @@
 
 #include "SDL_video.h"
 #include "SDL_mouse.h"
+#include "SDL_endian.h"
+#include "SDL_thread.h"
 #include "../SDL_sysvideo.h"
 #include "../SDL_pixels_c.h"
+#include "../SDL_framestats_c.h"
+#include "../SDL_evdev_c.h"
+#include "../SDL_scaling_c.h"
 #include "../../events/SDL_events_c.h"
 #include "SDL_fbvideo.h"
 #include "SDL_fbmouse_c.h"
@@ -49,10 +57,27 @@ static void DISPMANX_VideoQuit(_THIS);
 static void DISPMANX_WaitVBL(_THIS);
 static void DISPMANX_WaitIdle(_THIS);
 static void DISPMANX_DirectUpdate(_THIS, int numrects, SDL_Rect *rects);
+static void DISPMANX_PumpAll(_THIS);
+static int DISPMANX_LockHWSurface(_THIS, SDL_Surface *surface);
+static void DISPMANX_UnlockHWSurface(_THIS, SDL_Surface *surface);
+static int DISPMANX_FlipHWSurface(_THIS, SDL_Surface *surface);
 static void DISPMANX_BlankBackground(void);
 static int DISPMANX_AddMode(_THIS, unsigned int w, unsigned int h, int index);
 static void DISPMANX_FreeResources(void);
 static void DISPMANX_FreeBackground (void);
+static void DISPMANX_WaitUpdate(void);
+static void DISPMANX_ShowPage(void);
+static void DISPMANX_AddDamage(int page, int y1, int y2);
+static void DISPMANX_Expand8(const Uint8 *src, int src_pitch, Uint16 *dst,
+	int dst_pitch, int width, int height, const Uint16 *lut);
+
+//Con la subida asincrona usamos tres resources: uno en pantalla, uno
+//esperando al vsync y uno libre para escribir el siguiente frame.
+#define DISPMANX_MAX_RESOURCES 3
+
+//write_data() sube filas enteras, asi que el damage se guarda como franjas
+//de filas [y1, y2) por resource.
+#define DISPMANX_MAX_DAMAGE 16
 
 //MAC Variables para la inicialización del buffer
 int flip_page = 0;
@@ -66,7 +91,7 @@ typedef struct {
     DISPMANX_MODEINFO_T         amode;
     void                       *pixmem;
     DISPMANX_UPDATE_HANDLE_T    update;
-    DISPMANX_RESOURCE_HANDLE_T  resources[2];
+    DISPMANX_RESOURCE_HANDLE_T  resources[DISPMANX_MAX_RESOURCES];
     DISPMANX_ELEMENT_HANDLE_T   element;
     VC_IMAGE_TYPE_T 		pix_format;
     uint32_t                    vc_image_ptr;
@@ -81,9 +106,39 @@ typedef struct {
     DISPMANX_RESOURCE_HANDLE_T  b_resource;
     DISPMANX_ELEMENT_HANDLE_T   b_element;
     DISPMANX_UPDATE_HANDLE_T    b_update;	
-    
-    //Variable para saber si el usuario ha seteado la varable de entorno de ignorar ratio
-    int ignore_ratio;
+
+    //Subida asincrona (SDL_DISPMANX_ASYNC_FLIP): el update se envia sin esperar
+    //al vsync y el callback devuelve el semaforo cuando el firmware lo ha aplicado.
+    int async_flip;
+    int num_resources;
+    SDL_sem *update_sem;
+
+    //Historial de damage de cada resource: lo que ha cambiado en pixmem
+    //desde la ultima vez que se subio a ese resource.
+    int damage_y1[DISPMANX_MAX_RESOURCES][DISPMANX_MAX_DAMAGE];
+    int damage_y2[DISPMANX_MAX_RESOURCES][DISPMANX_MAX_DAMAGE];
+    int num_damage[DISPMANX_MAX_RESOURCES];
+
+    //Modo de 8bpp sin resources paletados: pixmem sigue siendo de 8bpp y las
+    //filas que se suben se expanden a RGB565 con la LUT en expmem.
+    int expand_8bpp;
+    Uint16 *expmem;
+    int exp_pitch;
+    Uint16 lut[256];
+    //SetColors ha cambiado la LUT y aun no se ha subido la pantalla con ella
+    int palette_pending;
+
+    //Modo sin copia (SDL_HWSURFACE con SDL_DISPMANX_ZEROCOPY): la superficie
+    //esta en memoria compartida vcsm y es la VideoCore quien la copia al resource.
+    int zero_copy;
+#if SDL_VIDEO_DRIVER_DISPMANX_VCSM
+    int vcsm_ready;
+    unsigned int vcsm_handle;
+    void *vcsm_mem;
+#endif
+
+    //Cuando la app nos dio cada frame, para SDL_GetFrameStats()
+    Uint32 queue_time[DISPMANX_MAX_RESOURCES];
 
 } __DISPMAN_VARIABLES_T;
 
@@ -144,6 +199,9 @@ static SDL_VideoDevice *DISPMANX_CreateDevice(int devindex)
 	this->SetColors = DISPMANX_SetColors;
 	this->UpdateRects = DISPMANX_DirectUpdate;
 	this->VideoQuit = DISPMANX_VideoQuit;
+	this->LockHWSurface = DISPMANX_LockHWSurface;
+	this->UnlockHWSurface = DISPMANX_UnlockHWSurface;
+	this->FlipHWSurface = DISPMANX_FlipHWSurface;
 	this->CheckHWBlit = NULL;
 	this->FillHWRect = NULL;
 	this->SetHWColorKey = NULL;
@@ -154,7 +212,7 @@ static SDL_VideoDevice *DISPMANX_CreateDevice(int devindex)
 	this->GrabInput = NULL;
 	this->GetWMInfo = NULL;
 	this->InitOSKeymap = DISPMANX_InitOSKeymap;
-	this->PumpEvents = DISPMANX_PumpEvents;
+	this->PumpEvents = DISPMANX_PumpAll;
 	this->CreateYUVOverlay = NULL;	
 
 	this->free = DISPMANX_DeleteDevice;
@@ -184,13 +242,38 @@ static int DISPMANX_VideoInit(_THIS, SDL_PixelFormat *vformat)
 	}
 #endif
 
+	//With SDL_DISPMANX_ASYNC_FLIP the update is submitted without waiting
+	//for vsync, so the app only blocks when it gets two frames ahead.
+	dispvars->async_flip = 0;
+	dispvars->num_resources = 2;
+#if !SDL_THREADS_DISABLED
+	{
+		const char *sdl_async = SDL_getenv("SDL_DISPMANX_ASYNC_FLIP");
+		if (sdl_async && SDL_atoi(sdl_async)) {
+			dispvars->update_sem = SDL_CreateSemaphore(1);
+			if (dispvars->update_sem != NULL) {
+				dispvars->async_flip = 1;
+				dispvars->num_resources = DISPMANX_MAX_RESOURCES;
+			}
+		}
+	}
+#endif
+
 	
 	/* Enable mouse and keyboard support */
-	if ( DISPMANX_OpenKeyboard(this) < 0 ) {
+	//Con SDL_INPUT_EVDEV la entrada viene de /dev/input/event*: el VT solo
+	//hace falta para el modo grafico, y sin el (headless) seguimos.
+	use_evdev = 0;
+#if SDL_INPUT_LINUXEV
+	if ( SDL_EvdevWanted() && SDL_EvdevInit() == 0 ) {
+		use_evdev = 1;
+	}
+#endif
+	if ( DISPMANX_OpenKeyboard(this) < 0 && !use_evdev ) {
 		DISPMANX_VideoQuit(this);
 		return(-1);
 	}
-	if ( DISPMANX_OpenMouse(this) < 0 ) {
+	if ( !use_evdev && DISPMANX_OpenMouse(this) < 0 ) {
 		const char *sdl_nomouse;
 		//MAC Si esto da problemas, es por los premisos de gpm sobre
 		//el raton en /dev/mice. Edita /etc/init.d/gpm y aniade
@@ -202,6 +285,14 @@ static int DISPMANX_VideoInit(_THIS, SDL_PixelFormat *vformat)
 			return(-1);
 		}
 	}
+	//Teclado y raton al epoll de SDL_WaitEvent(), que asi duerme en ellos
+	//en vez de mirar cada 10 ms si ha llegado algo.
+	if ( keyboard_fd >= 0 ) {
+		SDL_AddEventFD(keyboard_fd, 1);
+	}
+	if ( mouse_fd >= 0 ) {
+		SDL_AddEventFD(mouse_fd, 1);
+	}
 	
 	//MAC Esto es necesario para que SDL_SetVideoMode de SDL_Video.c (NO DISPMANX_SetVideoMode()) no
 	//se piense que tenemos un modo con paleta, porque eso haria que se llamase a DISPMANX_SetColors
@@ -217,6 +308,8 @@ static int DISPMANX_VideoInit(_THIS, SDL_PixelFormat *vformat)
 	//Esto es porque en juegos y emuladores tipo MAME y tal se entra por VideoInit() pero no por SetVideoMode(),
 	//donde dispvars->pixmem dejaraa de ser NULL y entonces sitendriamos que liberar cosas.
 	dispvars->pixmem = NULL;
+
+	SDL_FrameStatsInit();
 		
 	/* We're done! */
 	return(0);
@@ -279,6 +372,7 @@ static SDL_Surface *DISPMANX_SetVideoMode(_THIS, SDL_Surface *current,
 	Uint32 Rmask;
 	Uint32 Gmask;
 	Uint32 Bmask;
+	int i;
 	
 	//dispvars->pitch = width * ((bpp+7) /8);
 
@@ -319,37 +413,25 @@ static SDL_Surface *DISPMANX_SetVideoMode(_THIS, SDL_Surface *current,
 		dispvars->bits_per_pixel);
 	
 	//-----------------------------------------------------------------------------
-	//Esta parte no es fundamental, solo sirve para conservar el ratio del juego.
-	//Si no se hace y simplemente quitas estas lineas, se estira al modo fisico y ya, 
-	//quedando la imagen deformada si es de 4:3 en una tele de 16:9, que es lo que pasaba antes.	
-	//Simplemente hallamos ese ratio y con el hallamos la nueva anchura, considerando
-	//como altura la maxima fisica que tenemos establecida, o sea, la altura del modo fisico establecido. 
-	//Tambien se calcula la posicion horizontal en que debe empezar el rect de destino (dst_ypos), 
-	//para que no quede pegado a la parte izquierda de la pantalla al ser menor que la resolucion fisica, que
-	//obviamente no cambia. 
-	//Queda obsoleto si cambiamos la resolucion a una que tenga el mismo ratio que el modo original del juego.
-	
-	dispvars->ignore_ratio = (int) SDL_getenv("SDL_DISPMANX_IGNORE_RATIO");
-
-	if (dispvars->ignore_ratio)
-		vc_dispmanx_rect_set( &(dispvars->dst_rect), 0, 0, 
-	   		dispvars->amode.width , dispvars->amode.height );
-	else {
-		float orig_ratio = ((float)width / (float)height); 
-		int dst_width = dispvars->amode.height * orig_ratio;	
-		
-		//Si la anchura de la imagen escalada nos sale mayor que el ancho fisico de pantalla,
-		//mantenemos el ancho fisico de pantalla como anchura maxima.
-		if (dst_width > dispvars->amode.width) dst_width = dispvars->amode.width;
-
-		int dst_ypos  = (dispvars->amode.width - dst_width) / 2; 
-		printf ("\nUsing proportion ratio: %d / %d = %f", width, height, orig_ratio);
-		printf ("\nProgram rect, respecting original ratio: %d x %d \n", 
-		dst_width, dispvars->amode.height);
-
-		vc_dispmanx_rect_set( &(dispvars->dst_rect), dst_ypos, 0, 
-	   		dst_width , dispvars->amode.height );
-			
+	//El escalado lo hace el element. SDL_VIDEO_SCALING elige como: por defecto
+	//conservamos el ratio del juego, o estiramos al modo fisico si esta puesta
+	//SDL_DISPMANX_IGNORE_RATIO, como antes. Si no se conserva el ratio, una
+	//imagen de 4:3 queda deformada en una tele de 16:9.
+	{
+		SDL_Rect scale_src, scale_dst;
+		int policy = SDL_getenv("SDL_DISPMANX_IGNORE_RATIO") ? 
+		   SDL_SCALE_STRETCH : SDL_SCALE_ASPECT;
+
+		SDL_ComputeScaling(SDL_GetScalingPolicy(policy), width, height,
+		   dispvars->amode.width, dispvars->amode.height, 
+		   &scale_src, &scale_dst);
+		printf ("\nProgram rect on screen: %d,%d %d x %d\n", 
+		   scale_dst.x, scale_dst.y, scale_dst.w, scale_dst.h);
+
+		vc_dispmanx_rect_set( &(dispvars->dst_rect), scale_dst.x, 
+		   scale_dst.y, scale_dst.w, scale_dst.h );
+		vc_dispmanx_rect_set( &(dispvars->src_rect), scale_src.x << 16, 
+		   scale_src.y << 16, scale_src.w << 16, scale_src.h << 16 );
 	}
 
 	//---------------------------Dejamos configurados los rects---------------------
@@ -379,9 +461,6 @@ static SDL_Surface *DISPMANX_SetVideoMode(_THIS, SDL_Surface *current,
 	vc_dispmanx_rect_set (&(dispvars->bmp_rect), 0, 0, 
 	   width, height);	
 	
-	vc_dispmanx_rect_set (&(dispvars->src_rect), 0, 0, 
-	   width << 16, height << 16);	
-
 	//------------------------------------------------------------------------------
 	
 	//MAC Establecemos alpha. Para transparencia descomentar flags con or.
@@ -393,14 +472,45 @@ static SDL_Surface *DISPMANX_SetVideoMode(_THIS, SDL_Surface *current,
 	layerAlpha.mask	   = 0;
 	dispvars->alpha = &layerAlpha;
 	
-	//MAC Creo los resources. Me hacen falta dos para el double buffering
-	dispvars->resources[0] = vc_dispmanx_resource_create( 
-	   dispvars->pix_format, width, height, 
-	   &(dispvars->vc_image_ptr) );
-	
-	dispvars->resources[1] = vc_dispmanx_resource_create( 
-	   dispvars->pix_format, width, height,
-	   &(dispvars->vc_image_ptr) );
+	//En 8bpp usamos resources paletados si el firmware los tiene. Si no, o si
+	//se pide con SDL_DISPMANX_8BPP_EXPAND, los resources son RGB565 y expandimos
+	//con la paleta al subir.
+	dispvars->expand_8bpp = 0;
+	if (bpp == 8) {
+		const char *sdl_expand = SDL_getenv("SDL_DISPMANX_8BPP_EXPAND");
+		if (sdl_expand && SDL_atoi(sdl_expand))
+			dispvars->expand_8bpp = 1;
+	}
+
+	//MAC Creo los resources. Me hacen falta dos para el double buffering,
+	//o tres si la subida es asincrona.
+	for (i = 0; i < dispvars->num_resources; i++) {
+		dispvars->resources[i] = vc_dispmanx_resource_create( 
+		   dispvars->expand_8bpp ? VC_IMAGE_RGB565 : dispvars->pix_format,
+		   width, height, &(dispvars->vc_image_ptr) );
+		if (dispvars->resources[i] == DISPMANX_NO_HANDLE) {
+			if (bpp == 8 && !dispvars->expand_8bpp) {
+				printf ("\nDispmanx: no 8bpp resources, expanding to 16bpp");
+				while (i--)
+					vc_dispmanx_resource_delete( dispvars->resources[i] );
+				dispvars->expand_8bpp = 1;
+				continue;
+			}
+			SDL_SetError("Couldn't create dispmanx resource");
+			return(NULL);
+		}
+		//Un resource nuevo necesita la pantalla completa.
+		dispvars->num_damage[i] = 0;
+		DISPMANX_AddDamage(i, 0, height);
+	}
+	flip_page = 0;
+
+	if (dispvars->expand_8bpp) {
+		dispvars->exp_pitch = ALIGN_UP( width, 16 ) * 2;
+		dispvars->expmem = calloc( 1, dispvars->exp_pitch * height);
+		SDL_memset(dispvars->lut, 0, sizeof dispvars->lut);
+		dispvars->palette_pending = 0;
+	}
 	
 	//Reservo memoria para el array de pixles en RAM 
     	dispvars->pixmem = calloc( 1, dispvars->pitch * height);
@@ -445,6 +555,32 @@ static SDL_Surface *DISPMANX_SetVideoMode(_THIS, SDL_Surface *current,
 
 	current->pitch  = dispvars->pitch;
 	current->pixels = dispvars->pixmem;
+
+	//La excepcion: si la app pide SDL_HWSURFACE y SDL_DISPMANX_ZEROCOPY esta puesta,
+	//le damos un buffer vcsm. SDL_Flip() ya no copia nada con la CPU.
+	dispvars->zero_copy = 0;
+#if SDL_VIDEO_DRIVER_DISPMANX_VCSM
+	if ((flags & SDL_HWSURFACE) && !dispvars->expand_8bpp) {
+		const char *sdl_zerocopy = SDL_getenv("SDL_DISPMANX_ZEROCOPY");
+		if (sdl_zerocopy && SDL_atoi(sdl_zerocopy)) {
+			if (!dispvars->vcsm_ready)
+				dispvars->vcsm_ready = (vcsm_init() == 0);
+			if (dispvars->vcsm_ready)
+				dispvars->vcsm_handle = vcsm_malloc_cache(
+				   dispvars->pitch * height, VCSM_CACHE_TYPE_HOST, "SDL");
+			if (dispvars->vcsm_ready && dispvars->vcsm_handle) {
+				dispvars->vcsm_mem = vcsm_lock(dispvars->vcsm_handle);
+				SDL_memset(dispvars->vcsm_mem, 0, dispvars->pitch * height);
+				dispvars->zero_copy = 1;
+				current->flags &= ~SDL_SWSURFACE;
+				current->flags |= (SDL_HWSURFACE | SDL_DOUBLEBUF);
+				current->pixels = dispvars->vcsm_mem;
+			}
+			else
+				printf ("\nDispmanx: no vcsm memory, using a RAM surface");
+		}
+	}
+#endif
 	
 	//DISPMANX_FreeHWSurfaces(this);
 	//DISPMANX_InitHWSurfaces(this, current, surfaces_mem, surfaces_len);
@@ -548,6 +684,16 @@ static void DISPMANX_WaitIdle(_THIS)
 #define BLOCKSIZE_W 32
 #define BLOCKSIZE_H 32
 
+//Called from the VideoCore thread once the update is on screen.
+static void DISPMANX_UpdateDone(DISPMANX_UPDATE_HANDLE_T update, void *arg)
+{
+	int page = (int)(long)arg;
+	Uint32 now = SDL_FrameStatsNow();
+
+	SDL_FrameStatsFlip(now, now - dispvars->queue_time[page], 0);
+	SDL_SemPost(dispvars->update_sem);
+}
+
 static void DISPMANX_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
 {	
 	//En OpenGL tambin va as. No deberamos esperar para cambiar el buffer, de hecho la aplicacin
@@ -558,24 +704,212 @@ static void DISPMANX_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
 	//y espero a cambiar los buffers para no tener tearing, a pesar de que esta funcin se supone que no
 	//hace eso. Pero en OpenGL se hace lo mismo ya que la nica manera de mostrar los cambios es hacer
 	//un GL_SWAP_BUFFERS que tambin es bloqueante. 
-	//Volcamos desde el ram bitmap buffer al dispmanx resource buffer que toque. cada vez a uno.	
-	vc_dispmanx_resource_write_data( dispvars->resources[flip_page], 
-	   dispvars->pix_format, dispvars->pitch, dispvars->pixmem, 
-	   &(dispvars->bmp_rect) );
+	int i, page, y1, y2;
+	int height = dispvars->bmp_rect.height;
+	int dirty = 0;
+	VC_RECT_T rect;
+
+	if (dispvars->zero_copy) {
+		DISPMANX_FlipHWSurface(this, this->screen);
+		return;
+	}
+
+	//Apuntamos las filas que han cambiado en el historial de todos los resources:
+	//el que no se sube ahora las tendra pendientes para cuando le toque.
+	for (i = 0; i < numrects; i++) {
+		y1 = rects[i].y;
+		y2 = y1 + rects[i].h;
+		if (y1 < 0)
+			y1 = 0;
+		if (y2 > height)
+			y2 = height;
+		if (y2 <= y1)
+			continue;
+		for (page = 0; page < dispvars->num_resources; page++)
+			DISPMANX_AddDamage(page, y1, y2);
+		dirty = 1;
+	}
+	//Un cambio de paleta pendiente se sube aunque no haya rects
+	if (!dirty && !dispvars->palette_pending)
+		return;
+	dispvars->palette_pending = 0;
+	dispvars->queue_time[flip_page] = SDL_FrameStatsNow();
+
+	//Volcamos desde el ram bitmap buffer al dispmanx resource buffer que toque,
+	//pero solo las franjas que ese resource no tiene al dia.
+	for (i = 0; i < dispvars->num_damage[flip_page]; i++) {
+		y1 = dispvars->damage_y1[flip_page][i];
+		y2 = dispvars->damage_y2[flip_page][i];
+		vc_dispmanx_rect_set( &rect, 0, y1, 
+		   dispvars->bmp_rect.width, y2 - y1 );
+		if (dispvars->expand_8bpp) {
+			//write_data() toma las filas desde rect.y, asi que expandimos
+			//en expmem al mismo offset.
+			DISPMANX_Expand8((Uint8 *)dispvars->pixmem + y1 * dispvars->pitch,
+			   dispvars->pitch,
+			   (Uint16 *)((Uint8 *)dispvars->expmem + y1 * dispvars->exp_pitch),
+			   dispvars->exp_pitch, dispvars->bmp_rect.width, y2 - y1,
+			   dispvars->lut);
+			vc_dispmanx_resource_write_data( dispvars->resources[flip_page], 
+			   VC_IMAGE_RGB565, dispvars->exp_pitch, dispvars->expmem, 
+			   &rect );
+		}
+		else
+			vc_dispmanx_resource_write_data( dispvars->resources[flip_page], 
+			   dispvars->pix_format, dispvars->pitch, dispvars->pixmem, 
+			   &rect );
+	}
+	dispvars->num_damage[flip_page] = 0;
+	SDL_FrameStatsCopy(SDL_FrameStatsNow() - dispvars->queue_time[flip_page]);
+
+	DISPMANX_ShowPage();
+}
+
+//Puts resources[flip_page] on screen and moves on to the next one.
+static void DISPMANX_ShowPage(void)
+{
+	Uint32 start, now;
+
 	//Empieza actualizacin
 	dispvars->update = vc_dispmanx_update_start( 0 );
 
 	vc_dispmanx_element_change_source(dispvars->update, 
 	   dispvars->element, dispvars->resources[flip_page]);
 	
-	vc_dispmanx_update_submit_sync( dispvars->update );		
-	//vc_dispmanx_update_submit(dispvars->update, NULL, NULL); 
+	start = SDL_FrameStatsNow();
+	if (dispvars->async_flip) {
+		//Solo esperamos si el update anterior aun no se ha aplicado.
+		SDL_SemWait(dispvars->update_sem);
+		SDL_FrameStatsWait(SDL_FrameStatsNow() - start);
+		vc_dispmanx_update_submit(dispvars->update, 
+		   DISPMANX_UpdateDone, (void *)(long)flip_page);
+	}
+	else {
+		vc_dispmanx_update_submit_sync( dispvars->update );		
+		now = SDL_FrameStatsNow();
+		SDL_FrameStatsWait(now - start);
+		SDL_FrameStatsFlip(now, now - dispvars->queue_time[flip_page], 0);
+	}
 	//Acaba actualizacin
-	flip_page = !flip_page;
-	
+	flip_page = (flip_page + 1) % dispvars->num_resources;
+}
+
+static int DISPMANX_LockHWSurface(_THIS, SDL_Surface *surface)
+{
+	return(0);
+}
+
+static void DISPMANX_UnlockHWSurface(_THIS, SDL_Surface *surface)
+{
 	return;
 }
 
+static int DISPMANX_FlipHWSurface(_THIS, SDL_Surface *surface)
+{
+#if SDL_VIDEO_DRIVER_DISPMANX_VCSM
+	//Al desbloquear se vuelca la cache de la CPU, y la VideoCore copia el buffer
+	//al resource. Si el firmware no sabe hacerlo, lo copiamos nosotros.
+	dispvars->queue_time[flip_page] = SDL_FrameStatsNow();
+	vcsm_unlock_ptr(dispvars->vcsm_mem);
+	if (vc_dispmanx_resource_write_data_handle( dispvars->resources[flip_page],
+	   dispvars->pix_format, dispvars->pitch,
+	   vcsm_vc_hdl_from_hdl(dispvars->vcsm_handle), 0,
+	   &(dispvars->bmp_rect) ) != 0) {
+		dispvars->vcsm_mem = vcsm_lock(dispvars->vcsm_handle);
+		vc_dispmanx_resource_write_data( dispvars->resources[flip_page], 
+		   dispvars->pix_format, dispvars->pitch, dispvars->vcsm_mem, 
+		   &(dispvars->bmp_rect) );
+	}
+	else
+		dispvars->vcsm_mem = vcsm_lock(dispvars->vcsm_handle);
+	surface->pixels = dispvars->vcsm_mem;
+	SDL_FrameStatsCopy(SDL_FrameStatsNow() - dispvars->queue_time[flip_page]);
+
+	DISPMANX_ShowPage();
+#endif
+	return(0);
+}
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define PIXEL_PAIR(a, b)	((Uint32)(a) | ((Uint32)(b) << 16))
+#else
+#define PIXEL_PAIR(a, b)	(((Uint32)(a) << 16) | (Uint32)(b))
+#endif
+
+//Expands palettized rows to RGB565 through the LUT. The lookups can't be
+//vectorised with 256 entries, so we unroll and write two pixels per store
+//to halve the number of stores into expmem.
+static void DISPMANX_Expand8(const Uint8 *src, int src_pitch, Uint16 *dst,
+	int dst_pitch, int width, int height, const Uint16 *lut)
+{
+	while (height--) {
+		const Uint8 *s = src;
+		Uint32 *d = (Uint32 *)dst;
+		int w = width;
+
+		for (; w >= 8; w -= 8) {
+			d[0] = PIXEL_PAIR(lut[s[0]], lut[s[1]]);
+			d[1] = PIXEL_PAIR(lut[s[2]], lut[s[3]]);
+			d[2] = PIXEL_PAIR(lut[s[4]], lut[s[5]]);
+			d[3] = PIXEL_PAIR(lut[s[6]], lut[s[7]]);
+			s += 8;
+			d += 4;
+		}
+		for (; w >= 2; w -= 2) {
+			*d++ = PIXEL_PAIR(lut[s[0]], lut[s[1]]);
+			s += 2;
+		}
+		if (w)
+			*(Uint16 *)d = lut[*s];
+
+		src += src_pitch;
+		dst = (Uint16 *)((Uint8 *)dst + dst_pitch);
+	}
+}
+
+//Adds the rows [y1, y2) to the damage of a resource, merging bands that
+//overlap or touch. If there are too many, everything becomes one band.
+static void DISPMANX_AddDamage(int page, int y1, int y2)
+{
+	int *d1 = dispvars->damage_y1[page];
+	int *d2 = dispvars->damage_y2[page];
+	int n = dispvars->num_damage[page];
+	int i = 0;
+
+	while (i < n) {
+		if (y1 <= d2[i] && d1[i] <= y2) {
+			y1 = min(y1, d1[i]);
+			y2 = (y2 > d2[i]) ? y2 : d2[i];
+			n--;
+			d1[i] = d1[n];
+			d2[i] = d2[n];
+			//La franja ha crecido: hay que volver a mirar las demas.
+			i = 0;
+		} else
+			i++;
+	}
+	if (n == DISPMANX_MAX_DAMAGE) {
+		for (i = 0; i < n; i++) {
+			y1 = min(y1, d1[i]);
+			y2 = (y2 > d2[i]) ? y2 : d2[i];
+		}
+		n = 0;
+	}
+	d1[n] = y1;
+	d2[n] = y2;
+	dispvars->num_damage[page] = n + 1;
+}
+
+//Waits until the last async update has been applied by the firmware, so
+//that every resource can be touched or deleted.
+static void DISPMANX_WaitUpdate(void)
+{
+	if (dispvars->async_flip) {
+		SDL_SemWait(dispvars->update_sem);
+		SDL_SemPost(dispvars->update_sem);
+	}
+}
+
 /*static void DISPMANX_DirectUpdate8bpp(_THIS, int numrects, SDL_Rect *rects)
 {	
 	//Version que incluye conversion de 8bpp paletado a 32bpp directos.
@@ -623,6 +957,16 @@ static void DISPMANX_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
    another SDL video routine -- notably UpdateRects.
 */
 
+//PumpEvents: ademas de la entrada, presenta un cambio de paleta que la
+//aplicacion no ha acompanado de un Flip/UpdateRects, como haria una paleta
+//por hardware.
+static void DISPMANX_PumpAll(_THIS)
+{
+	if (dispvars->palette_pending && SDL_EventThreadID() == 0)
+		DISPMANX_DirectUpdate(this, 0, NULL);
+	DISPMANX_PumpEvents(this);
+}
+
 static int DISPMANX_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
 {
 	int i;
@@ -630,10 +974,27 @@ static int DISPMANX_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *col
 	
 	//Set up the colormap
 	for (i = 0; i < ncolors; i++) {
-		pal[i] = RGB565 ((colors[i]).r, (colors[i]).g, (colors[i]).b);
+		pal[firstcolor+i] = RGB565 ((colors[i]).r, (colors[i]).g, (colors[i]).b);
 	}
-	vc_dispmanx_resource_set_palette(  dispvars->resources[flip_page], pal, 0, sizeof pal );
-	vc_dispmanx_resource_set_palette(  dispvars->resources[!flip_page], pal, 0, sizeof pal );
+
+	if (dispvars->expand_8bpp) {
+		//Sin paleta por hardware el cambio no se ve hasta que volvemos a
+		//expandir: marcamos la pantalla completa en todos los resources.
+		//Si la aplicacion hace Flip/UpdateRects despues, sube con ese frame;
+		//si no (ciclos de paleta sin redibujar), la sube el siguiente
+		//PumpEvents. Con el hilo de eventos no podemos esperar a eso.
+		SDL_memcpy(dispvars->lut, pal, sizeof pal);
+		for (i = 0; i < dispvars->num_resources; i++)
+			DISPMANX_AddDamage(i, 0, dispvars->bmp_rect.height);
+		dispvars->palette_pending = 1;
+		if (SDL_EventThreadID() != 0)
+			DISPMANX_DirectUpdate(this, 0, NULL);
+		return(1);
+	}
+
+	DISPMANX_WaitUpdate();
+	for (i = 0; i < dispvars->num_resources; i++)
+		vc_dispmanx_resource_set_palette(  dispvars->resources[i], pal, 0, sizeof pal );
 
 	return(1);
 }
@@ -675,13 +1036,27 @@ static SDL_Rect **DISPMANX_ListModes(_THIS, SDL_PixelFormat *format, Uint32 flag
 }
 
 static void DISPMANX_FreeResources(void){
+	int i;
+
 	free (dispvars->pixmem);
+	free (dispvars->expmem);
+	dispvars->expmem = NULL;
+#if SDL_VIDEO_DRIVER_DISPMANX_VCSM
+	if (dispvars->zero_copy) {
+		vcsm_unlock_ptr(dispvars->vcsm_mem);
+		vcsm_free(dispvars->vcsm_handle);
+		dispvars->vcsm_handle = 0;
+		dispvars->vcsm_mem = NULL;
+		dispvars->zero_copy = 0;
+	}
+#endif
 	      
 	//MAC liberamos lo relacionado con dispmanx
+	DISPMANX_WaitUpdate();
 	dispvars->update = vc_dispmanx_update_start( 0 );
     	
-    	vc_dispmanx_resource_delete( dispvars->resources[0] );
-    	vc_dispmanx_resource_delete( dispvars->resources[1] );
+	for (i = 0; i < dispvars->num_resources; i++)
+    		vc_dispmanx_resource_delete( dispvars->resources[i] );
 	vc_dispmanx_element_remove(dispvars->update, dispvars->element);
 	
 	vc_dispmanx_update_submit_sync( dispvars->update );		
@@ -717,7 +1092,24 @@ static void DISPMANX_VideoQuit(_THIS)
 		bcm_host_deinit();
 	}
 
+	if (dispvars->update_sem) {
+		SDL_DestroySemaphore(dispvars->update_sem);
+		dispvars->update_sem = NULL;
+	}
+#if SDL_VIDEO_DRIVER_DISPMANX_VCSM
+	if (dispvars->vcsm_ready) {
+		vcsm_exit();
+		dispvars->vcsm_ready = 0;
+	}
+#endif
+
 	DISPMANX_CloseMouse(this);
+#if SDL_INPUT_LINUXEV
+	if ( use_evdev ) {
+		SDL_EvdevQuit();
+		use_evdev = 0;
+	}
+#endif
 	DISPMANX_CloseKeyboard(this);
 	
 	//MAC Set custom video mode block 2
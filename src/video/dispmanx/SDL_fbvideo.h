@@ -54,6 +54,7 @@ struct SDL_PrivateVideoData {
 	struct termios saved_kbd_termios;
 
 	int mouse_fd;
+	int use_evdev;
 #if SDL_INPUT_TSLIB
 	struct tsdev *ts_dev;
 #endif
@@ -84,6 +85,7 @@ struct SDL_PrivateVideoData {
 #define saved_kbd_mode		(this->hidden->saved_kbd_mode)
 #define saved_kbd_termios	(this->hidden->saved_kbd_termios)
 #define mouse_fd		(this->hidden->mouse_fd)
+#define use_evdev		(this->hidden->use_evdev)
 #if SDL_INPUT_TSLIB
 #define ts_dev			(this->hidden->ts_dev)
 #endif
@@ -43,6 +43,7 @@
 #include "SDL_timer.h"
 #include "SDL_mutex.h"
 #include "../SDL_sysvideo.h"
+#include "../SDL_evdev_c.h"
 #include "../../events/SDL_sysevents.h"
 #include "../../events/SDL_events_c.h"
 #include "SDL_fbvideo.h"
@@ -234,6 +235,7 @@ void KMS_LeaveGraphicsMode(_THIS)
 void KMS_CloseKeyboard(_THIS)
 {
 	if ( keyboard_fd >= 0 ) {
+		SDL_DelEventFD(keyboard_fd, 1);
 		KMS_LeaveGraphicsMode(this);
 		if ( keyboard_fd > 0 ) {
 			close(keyboard_fd);
@@ -330,6 +332,9 @@ static enum {
 
 void KMS_CloseMouse(_THIS)
 {
+	if ( mouse_fd >= 0 ) {
+		SDL_DelEventFD(mouse_fd, 1);
+	}
 #if SDL_INPUT_TSLIB
 	if (ts_dev != NULL) {
 		ts_close(ts_dev);
@@ -966,15 +971,55 @@ static void switch_vt(_THIS, unsigned short which)
 	SDL_mutexV(hw_lock);
 }
 
+static int handle_key(_THIS, int scancode, int pressed)
+{
+	SDL_keysym keysym;
+
+	TranslateKey(scancode, &keysym);
+	if ( (keysym.sym == SDLK_UNKNOWN) && use_evdev ) {
+		/* No console keymap (headless?), go by the key code */
+		keysym.sym = SDL_EvdevKeysym(scancode);
+	}
+	/* Handle Ctrl-Alt-FN for vt switch */
+	switch (keysym.sym) {
+	    case SDLK_F1:
+	    case SDLK_F2:
+	    case SDLK_F3:
+	    case SDLK_F4:
+	    case SDLK_F5:
+	    case SDLK_F6:
+	    case SDLK_F7:
+	    case SDLK_F8:
+	    case SDLK_F9:
+	    case SDLK_F10:
+	    case SDLK_F11:
+	    case SDLK_F12:
+		if ( (SDL_GetModState() & KMOD_CTRL) &&
+		     (SDL_GetModState() & KMOD_ALT) ) {
+			if ( pressed ) {
+				switch_vt(this, (keysym.sym-SDLK_F1)+1);
+			}
+			break;
+		}
+		/* Fall through to normal processing */
+	    default:
+		return SDL_PrivateKeyboard(pressed, &keysym);
+	}
+	return 0;
+}
+
 static void handle_keyboard(_THIS)
 {
 	unsigned char keybuf[BUFSIZ];
 	int i, nread;
 	int pressed;
 	int scancode;
-	SDL_keysym keysym;
 
 	nread = read(keyboard_fd, keybuf, BUFSIZ);
+	if ( use_evdev ) {
+		/* The keys come from evdev, this just drains the tty */
+		return;
+	}
 	for ( i=0; i<nread; ++i ) {
 		scancode = keybuf[i] & 0x7F;
 		if ( keybuf[i] & 0x80 ) {
@@ -982,36 +1027,21 @@ static void handle_keyboard(_THIS)
 		} else {
 			pressed = SDL_PRESSED;
 		}
-		TranslateKey(scancode, &keysym);
-		/* Handle Ctrl-Alt-FN for vt switch */
-		switch (keysym.sym) {
-		    case SDLK_F1:
-		    case SDLK_F2:
-		    case SDLK_F3:
-		    case SDLK_F4:
-		    case SDLK_F5:
-		    case SDLK_F6:
-		    case SDLK_F7:
-		    case SDLK_F8:
-		    case SDLK_F9:
-		    case SDLK_F10:
-		    case SDLK_F11:
-		    case SDLK_F12:
-			if ( (SDL_GetModState() & KMOD_CTRL) &&
-			     (SDL_GetModState() & KMOD_ALT) ) {
-				if ( pressed ) {
-					switch_vt(this, (keysym.sym-SDLK_F1)+1);
-				}
-				break;
-			}
-			/* Fall through to normal processing */
-		    default:
-			posted += SDL_PrivateKeyboard(pressed, &keysym);
-			break;
-		}
+		posted += handle_key(this, scancode, pressed);
 	}
 }
 
+#if SDL_INPUT_LINUXEV
+/* Linux key codes below 128 are the medium raw scancodes */
+static int handle_evdev_key(_THIS, int code, int pressed)
+{
+	if ( code >= SDL_arraysize(keymap) ) {
+		return 0;
+	}
+	return handle_key(this, code, pressed);
+}
+#endif
+
 void KMS_PumpEvents(_THIS)
 {
 	fd_set fdset;
@@ -1059,6 +1089,11 @@ void KMS_PumpEvents(_THIS)
 				}
 			}
 		}
+#if SDL_INPUT_LINUXEV
+		if ( use_evdev ) {
+			posted += SDL_EvdevPump(this, handle_evdev_key);
+		}
+#endif
 	} while ( posted );
 }
 
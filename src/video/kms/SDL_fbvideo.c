@@ -29,6 +29,10 @@
 #include "SDL_mouse.h"
 #include "../SDL_sysvideo.h"
 #include "../SDL_pixels_c.h"
+#include "../SDL_shadowblit_c.h"
+#include "../SDL_framestats_c.h"
+#include "../SDL_evdev_c.h"
+#include "../SDL_scaling_c.h"
 #include "../../events/SDL_events_c.h"
 #include "SDL_fbvideo.h"
 #include "SDL_fbmouse_c.h"
@@ -105,6 +109,11 @@ static void KMS_FreeHWSurface(_THIS, SDL_Surface *surface);
 static void KMS_WaitVBL(_THIS);
 static void KMS_WaitIdle(_THIS);
 static int KMS_FlipHWSurface(_THIS, SDL_Surface *surface);
+static void KMS_WaitPageFlip(void);
+static void KMS_WaitPageFree(int page);
+static void KMS_PumpAll(_THIS);
+void page_flip_handler(int fd, unsigned int frame,
+                  unsigned int sec, unsigned int usec, void *data);
 
 //MAC Variables para la inicialización del buffer
 int fd, modes;
@@ -117,17 +126,87 @@ drmEventContext evctx;
 drmModePlaneRes *plane_resources;
 drmModePlane *ovr;
 
-uint32_t fb_id[2];
+//Scanout buffer ring. Each buffer goes FREE (we may draw into it) ->
+//QUEUED (flipped by the app, waiting for the CRTC) -> PENDING (submitted
+//with drmModePageFlip) -> DISPLAYED, and back to FREE once the next
+//buffer has been displayed. The transitions are done by page_flip_handler.
+#define KMS_MAX_BUFFERS 4
+
+#define KMS_BUFFER_FREE		0
+#define KMS_BUFFER_QUEUED	1
+#define KMS_BUFFER_PENDING	2
+#define KMS_BUFFER_DISPLAYED	3
+
+uint32_t fb_id[KMS_MAX_BUFFERS];
 uint32_t plane_id = 0;
 uint32_t pixel_format = 0;
-int waiting_for_vblank;
+//Paleta de C8: la LUT de gamma del CRTC. Guardamos la original para
+//dejarla como estaba al salir.
+int gamma_size = 0;
+int gamma_saved = 0;
+uint16_t pal_r[256], pal_g[256], pal_b[256];
+uint16_t saved_r[256], saved_g[256], saved_b[256];
+int async_flip = 0;
 uint32_t src_width, src_height, src_offsetx, src_offsety;
+//Rect del modo físico en que se ve la aplicación (SDL_VIDEO_SCALING)
+SDL_Rect plane_dst;
 int flip_page = 0;
-char *mapped_vmem[2];
+char *mapped_vmem[KMS_MAX_BUFFERS];
+
+int num_buffers = 2;
+int buf_state[KMS_MAX_BUFFERS];
+unsigned int buf_seq[KMS_MAX_BUFFERS];
+//Cuando se encolo cada buffer, para SDL_GetFrameStats()
+Uint32 queue_time[KMS_MAX_BUFFERS];
+unsigned int queue_seq = 0;
+int pending_page = -1;
+int last_page = 0;
+
+//Shadow mode damage: the areas of the shadow that each buffer is missing.
+//When a list fills up it collapses into its bounding box.
+#define KMS_MAX_DAMAGE 16
+SDL_Rect buf_damage[KMS_MAX_BUFFERS][KMS_MAX_DAMAGE];
+int buf_numdamage[KMS_MAX_BUFFERS];
+
+//Atomic modesetting: plane property ids, looked up once per mode set
+int use_atomic = 0;
+struct {
+	uint32_t fb_id, crtc_id;
+	uint32_t src_x, src_y, src_w, src_h;
+	uint32_t crtc_x, crtc_y, crtc_w, crtc_h;
+	uint32_t damage_clips;
+} plane_props;
 
-struct kms_bo *bo[2];
 struct kms_driver *kms;
 
+//Cache de buffers de scanout (BO + FB + mapeo). SetVideoMode devuelve aquí
+//los buffers del modo anterior y los vuelve a coger si el nuevo tiene el
+//mismo tamaño y formato, así que cambiar entre menú y juego no crea ni
+//destruye BOs. Sólo se liberan cuando hace falta sitio para otro tamaño.
+//Durante el cambio de modo conviven los buffers del modo anterior (por si
+//hay que volver a él), los del nuevo y el que aún se ve en el overlay.
+#define KMS_CACHE_SIZE (2 * (KMS_MAX_BUFFERS + 1) + 2)
+struct kms_cached_buffer {
+	struct kms_bo *bo;
+	uint32_t fb_id;
+	char *map;
+	int width, height, stride;
+	uint32_t format;
+	int used;
+	int prev_used;	//used by the mode being replaced
+	int pinned;	//on screen until the new mode's first flip lands
+};
+struct kms_cached_buffer buf_cache[KMS_CACHE_SIZE];
+
+//What the mode being replaced had, to put it back if SetVideoMode fails
+uint32_t prev_fb_id[KMS_MAX_BUFFERS];
+char *prev_mapped_vmem[KMS_MAX_BUFFERS];
+uint32_t prev_crtc_fb_id = 0;
+
+//Los buffers del anillo tienen el tamaño de la aplicación y sólo se ven en
+//el overlay. El CRTC necesita un fb del tamaño del modo: uno negro.
+uint32_t crtc_fb_id = 0;
+
 /* FB driver bootstrap functions */
 
 static int KMS_Available(void)
@@ -191,7 +270,7 @@ static SDL_VideoDevice *KMS_CreateDevice(int devindex)
 	this->GrabInput = NULL;
 	this->GetWMInfo = NULL;
 	this->InitOSKeymap = KMS_InitOSKeymap;
-	this->PumpEvents = KMS_PumpEvents;
+	this->PumpEvents = KMS_PumpAll;
 	this->CreateYUVOverlay = NULL;	
 
 	this->free = KMS_DeleteDevice;
@@ -209,11 +288,11 @@ static int KMS_AddMode(_THIS, int index, unsigned int w, unsigned int h, int che
 	SDL_Rect *mode;
 	int next_mode;
 
-	// Check to see if we already have this mode
-	if ( SDL_nummodes[index] > 0 ) {
-		mode = SDL_modelist[index][SDL_nummodes[index]-1];
+	// Check to see if we already have this mode. The connector lists the
+	// same size once per refresh rate, so look at the whole list.
+	for ( next_mode = 0; next_mode < SDL_nummodes[index]; next_mode++ ) {
+		mode = SDL_modelist[index][next_mode];
 		if ( (mode->w == w) && (mode->h == h) ) {
-			printf("\nWe already have mode %dx%d at %d bytes per pixel\n", w, h, index+1);
 			return(0);
 		}
 	}
@@ -246,6 +325,26 @@ static int KMS_AddMode(_THIS, int index, unsigned int w, unsigned int h, int che
 	return(0);
 }
 
+static int cmpmodes(const void *va, const void *vb)
+{
+    const SDL_Rect *a = *(const SDL_Rect**)va;
+    const SDL_Rect *b = *(const SDL_Rect**)vb;
+    if ( a->h == b->h )
+        return b->w - a->w;
+    else
+        return b->h - a->h;
+}
+
+static void KMS_SortModes(_THIS)
+{
+	int i;
+	for ( i=0; i<NUM_MODELISTS; ++i ) {
+		if ( SDL_nummodes[i] > 0 ) {
+			SDL_qsort(SDL_modelist[i], SDL_nummodes[i], sizeof *SDL_modelist[i], cmpmodes);
+		}
+	}
+}
+
 static int KMS_VideoInit(_THIS, SDL_PixelFormat *vformat)
 {
 	int i,j;
@@ -266,6 +365,17 @@ static int KMS_VideoInit(_THIS, SDL_PixelFormat *vformat)
                 printf("\nfailed to create kms driver\n");
                 exit(0);
         }	
+
+	//MAC Atomic pageflip si el driver lo soporta (SDL_KMS_ATOMIC=0 lo evita)
+	{
+		const char *sdl_atomic = SDL_getenv("SDL_KMS_ATOMIC");
+		use_atomic = 0;
+		if ( !sdl_atomic || SDL_atoi(sdl_atomic) ) {
+			use_atomic = 
+			   (drmSetClientCap(fd, DRM_CLIENT_CAP_ATOMIC, 1) == 0);
+		}
+		printf ("\nUsando %s pageflip", use_atomic ? "atomic" : "legacy");
+	}
 	
 	//MAC Adquirimos resources		
 	resources = drmModeGetResources(fd);
@@ -300,41 +410,68 @@ static int KMS_VideoInit(_THIS, SDL_PixelFormat *vformat)
         	drmModeFreeEncoder(encoder);
 	}
         
-	/* Limpiamos listas de modos disponibles y añadimos los modos desde la lista de modos*/
-	/* Esto se puede hacer mejor añadiendo los modos desde los modos del conector        */
+	/* Limpiamos listas de modos disponibles y añadimos los modos del conector. */
+	/* Si el conector no trae ninguno (sin EDID) usamos la tabla CEA.            */
 	for ( i=0; i<NUM_MODELISTS; ++i ) {
 		SDL_nummodes[i] = 0;
 		SDL_modelist[i] = NULL;
 	}	
 	
-	for (i = 0; i < drm_num_cea_modes; i++){
-	   for (j = 0; j < NUM_MODELISTS; j++){
-	      //Añado cada modo a la lista 0 (8bpp), lista 1 (16), lista 2(24)..
-	      KMS_AddMode(this, j, edid_cea_modes[i].hdisplay, 
-	         edid_cea_modes[i].vdisplay, 0);
-	      
-	      printf("Añadiendo modo %d x %d - %d bpp\n", 
-	         edid_cea_modes[i].hdisplay, edid_cea_modes[i].vdisplay,
-	         (j+1)*8);
+	if (connector->count_modes > 0) {
+	   for (i = 0; i < connector->count_modes; i++){
+	      //Los modos entrelazados no nos sirven para el plano
+	      if (connector->modes[i].flags & DRM_MODE_FLAG_INTERLACE)
+	         continue;
+	      printf("\nAñadiendo modo %d x %d @ %d Hz", 
+	         connector->modes[i].hdisplay, connector->modes[i].vdisplay,
+	         connector->modes[i].vrefresh);
+	      for (j = 0; j < NUM_MODELISTS; j++)
+	         KMS_AddMode(this, j, connector->modes[i].hdisplay, 
+	            connector->modes[i].vdisplay, 0);
+	   }
+	}
+	else {
+	   for (i = 0; i < drm_num_cea_modes; i++){
+	      for (j = 0; j < NUM_MODELISTS; j++){
+	         //Añado cada modo a la lista 0 (8bpp), lista 1 (16), lista 2(24)..
+	         KMS_AddMode(this, j, edid_cea_modes[i].hdisplay, 
+	            edid_cea_modes[i].vdisplay, 0);
+	      }
 	   }
 	}
+	KMS_SortModes(this);
 	
-	//MAC Para que las funciones GetVideoInfo() devuelvan un SDL_VideoInfo con contenidos.
-        //NOTA: Los valores de current_h y current_w están puestos a fuego pero esto ESTÁ MAL.
-	//Arréglalo cuando retomes este backend!!!
+	//MAC Para que las funciones GetVideoInfo() devuelvan un SDL_VideoInfo con contenidos:
+	//el modo preferido del conector, que es el nativo en un panel.
 	this->info.current_w = 1920;
         this->info.current_h = 1080;
+	for (i = 0; i < connector->count_modes; i++){
+	   if (i == 0 || (connector->modes[i].type & DRM_MODE_TYPE_PREFERRED)) {
+	      this->info.current_w = connector->modes[i].hdisplay;
+	      this->info.current_h = connector->modes[i].vdisplay;
+	   }
+	   if (connector->modes[i].type & DRM_MODE_TYPE_PREFERRED)
+	      break;
+	}
         this->info.wm_available = 0;
         this->info.hw_available = 1;
         this->info.video_mem = 32768 /1024;	
 	this->info.video_mem = 32768 /1024;
 
 	/* Enable mouse and keyboard support */
-	if ( KMS_OpenKeyboard(this) < 0 ) {
+	//Con SDL_INPUT_EVDEV la entrada viene de /dev/input/event*: el VT sólo
+	//hace falta para el modo gráfico, y sin él (headless) seguimos.
+	use_evdev = 0;
+#if SDL_INPUT_LINUXEV
+	if ( SDL_EvdevWanted() && SDL_EvdevInit() == 0 ) {
+		use_evdev = 1;
+	}
+#endif
+	if ( KMS_OpenKeyboard(this) < 0 && !use_evdev ) {
 		KMS_VideoQuit(this);
 		return(-1);
 	}
-	if ( KMS_OpenMouse(this) < 0 ) {
+	if ( !use_evdev && KMS_OpenMouse(this) < 0 ) {
 		const char *sdl_nomouse;
 		//MAC Si esto da problemas, es por los premisos de gpm sobre
 		//el ratón en /dev/mice. Edita /etc/init.d/gpm y añade
@@ -347,6 +484,16 @@ static int KMS_VideoInit(_THIS, SDL_PixelFormat *vformat)
 			return(-1);
 		}
 	}
+	//Teclado y ratón al epoll de SDL_WaitEvent(), que así duerme en ellos
+	//en vez de mirar cada 10 ms si ha llegado algo. El fd de DRM también,
+	//para que los flips asíncronos avancen mientras la app espera.
+	if ( keyboard_fd >= 0 ) {
+		SDL_AddEventFD(keyboard_fd, 1);
+	}
+	if ( mouse_fd >= 0 ) {
+		SDL_AddEventFD(mouse_fd, 1);
+	}
+	SDL_AddEventFD(fd, 0);
 
 #if !SDL_THREADS_DISABLED
 	/* Create the hardware surface lock mutex */
@@ -359,7 +506,35 @@ static int KMS_VideoInit(_THIS, SDL_PixelFormat *vformat)
 #endif
 	
 	vformat->BitsPerPixel = 32;
+
+	//With SDL_KMS_ASYNC_FLIP the flip is queued and we return at once:
+	//the wait for it is done on the next Lock/Flip instead.
+	{
+		const char *sdl_async = SDL_getenv("SDL_KMS_ASYNC_FLIP");
+		async_flip = (sdl_async && SDL_atoi(sdl_async));
+	}
+
+	//Triple buffering by default when flips don't block, so we can keep
+	//drawing while one buffer is on screen and another one is queued.
+	{
+		const char *sdl_buffers = SDL_getenv("SDL_KMS_BUFFERS");
+		num_buffers = async_flip ? 3 : 2;
+		if (sdl_buffers)
+			num_buffers = SDL_atoi(sdl_buffers);
+		if (num_buffers < 2)
+			num_buffers = 2;
+		if (num_buffers > KMS_MAX_BUFFERS)
+			num_buffers = KMS_MAX_BUFFERS;
+	}
+
+	memset(&evctx, 0, sizeof evctx);
+	evctx.version = DRM_EVENT_CONTEXT_VERSION;
+	evctx.vblank_handler = NULL;
+	evctx.page_flip_handler = page_flip_handler;
+	pending_page = -1;
 	
+	SDL_FrameStatsInit();
+
 	/* We're done! */
 	printf ("\nKMS_VideoInit retorna correctamente");
 	return(0);
@@ -375,6 +550,70 @@ static void KMS_DirectUpdate(_THIS, int numrects, SDL_Rect *rects);
 
 
 
+//Tells whether mode a is a better pick than mode b. Smaller wins, since the
+//CRTC then has less to read every frame. For the same size we want the
+//SDL_KMS_REFRESH rate if one was given, then the connector's preferred mode.
+static int KMS_ModeBetter(drmModeModeInfo *a, drmModeModeInfo *b, int refresh)
+{
+	int area_a = a->hdisplay * a->vdisplay;
+	int area_b = b->hdisplay * b->vdisplay;
+
+	if (area_a != area_b)
+		return (area_a < area_b);
+	if (refresh && (a->vrefresh == refresh) != (b->vrefresh == refresh))
+		return (a->vrefresh == refresh);
+	return ((a->type & DRM_MODE_TYPE_PREFERRED) &&
+		!(b->type & DRM_MODE_TYPE_PREFERRED));
+}
+
+//Picks the connector mode that will show a width x height surface: the
+//smallest one it fits in. SDL_KMS_NATIVE_MODE=1 sticks to the preferred
+//mode and leaves all the scaling to the plane. If the surface is bigger
+//than every mode, the preferred mode (or else the largest) is used and the
+//plane scales down. Returns 0 only if the connector has no usable mode.
+static int KMS_FindMode(int width, int height, drmModeModeInfo *mode)
+{
+	drmModeModeInfo *best = NULL;
+	drmModeModeInfo *fallback = NULL;
+	drmModeModeInfo *m;
+	const char *env;
+	int refresh = 0;
+	int native = 0;
+	int i;
+
+	env = SDL_getenv("SDL_KMS_REFRESH");
+	if (env)
+		refresh = SDL_atoi(env);
+	env = SDL_getenv("SDL_KMS_NATIVE_MODE");
+	if (env)
+		native = SDL_atoi(env);
+
+	for (i = 0; i < connector->count_modes; i++) {
+		m = &connector->modes[i];
+		if (m->flags & DRM_MODE_FLAG_INTERLACE)
+			continue;
+		if (fallback == NULL ||
+		    ((m->type & DRM_MODE_TYPE_PREFERRED) &&
+		     !(fallback->type & DRM_MODE_TYPE_PREFERRED)) ||
+		    (!(fallback->type & DRM_MODE_TYPE_PREFERRED) &&
+		     m->hdisplay * m->vdisplay >
+		     fallback->hdisplay * fallback->vdisplay))
+			fallback = m;
+		if (m->hdisplay < width || m->vdisplay < height)
+			continue;
+		if (native && !(m->type & DRM_MODE_TYPE_PREFERRED))
+			continue;
+		if (best == NULL || KMS_ModeBetter(m, best, refresh))
+			best = m;
+	}
+	if (best == NULL)
+		best = fallback;
+	if (best == NULL)
+		return 0;
+	*mode = *best;
+	return 1;
+}
+
 static int complete_mode (drmModeModeInfo *modinfo)
 {
 	//MAC En esta función completamos los datos de los modos desde
@@ -408,6 +647,66 @@ static int complete_mode (drmModeModeInfo *modinfo)
 }
 
 
+//Looks up a property of a DRM object by name. Returns its id, or 0 if the
+//object doesn't have it, and stores its current value in *value.
+static uint32_t KMS_GetProperty(uint32_t object_id, uint32_t object_type,
+				const char *name, uint64_t *value)
+{
+	drmModeObjectProperties *props;
+	drmModePropertyRes *prop;
+	uint32_t i, id = 0;
+
+	props = drmModeObjectGetProperties(fd, object_id, object_type);
+	if (!props)
+		return 0;
+	for (i = 0; i < props->count_props && !id; i++) {
+		prop = drmModeGetProperty(fd, props->props[i]);
+		if (!prop)
+			continue;
+		if (strcmp(prop->name, name) == 0) {
+			id = prop->prop_id;
+			if (value)
+				*value = props->prop_values[i];
+		}
+		drmModeFreeProperty(prop);
+	}
+	drmModeFreeObjectProperties(props);
+	return id;
+}
+
+//Once a client asks for atomic the kernel also lists the primary and cursor
+//planes. Planes without a type property are overlays (legacy clients).
+static int KMS_IsOverlayPlane(uint32_t id)
+{
+	uint64_t type = DRM_PLANE_TYPE_OVERLAY;
+
+	KMS_GetProperty(id, DRM_MODE_OBJECT_PLANE, "type", &type);
+	return (type == DRM_PLANE_TYPE_OVERLAY);
+}
+
+//Fills plane_props for the chosen plane. Returns 0 if any is missing.
+static int KMS_GetPlaneProperties(void)
+{
+	plane_props.fb_id = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "FB_ID", NULL);
+	plane_props.crtc_id = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_ID", NULL);
+	plane_props.src_x = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_X", NULL);
+	plane_props.src_y = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_Y", NULL);
+	plane_props.src_w = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_W", NULL);
+	plane_props.src_h = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "SRC_H", NULL);
+	plane_props.crtc_x = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_X", NULL);
+	plane_props.crtc_y = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_Y", NULL);
+	plane_props.crtc_w = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_W", NULL);
+	plane_props.crtc_h = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_H", NULL);
+	//Optional: only drivers that can do partial updates have it
+	plane_props.damage_clips = KMS_GetProperty(plane_id, DRM_MODE_OBJECT_PLANE, "FB_DAMAGE_CLIPS", NULL);
+
+	return (plane_props.fb_id && plane_props.crtc_id &&
+		plane_props.src_x && plane_props.src_y &&
+		plane_props.src_w && plane_props.src_h &&
+		plane_props.crtc_x && plane_props.crtc_y &&
+		plane_props.crtc_w && plane_props.crtc_h);
+}
+
 static struct kms_bo *
 KMS_allocate_buffer(int width, int height, int *stride)
 {
@@ -438,90 +737,402 @@ KMS_allocate_buffer(int width, int height, int *stride)
         return bo;
 }
 
+static int KMS_FormatBytes(uint32_t format)
+{
+	switch (format) {
+	   case DRM_FORMAT_C8:
+	      return 1;
+	   case DRM_FORMAT_RGB565:
+	      return 2;
+	   default:
+	      return 4;
+	}
+}
+
+static int KMS_PlaneHasFormat(uint32_t format)
+{
+	int i;
+
+	for (i = 0; i < ovr->count_formats; i++) {
+		if (ovr->formats[i] == format)
+			return 1;
+	}
+	return 0;
+}
+
+//C8 needs the CRTC's gamma LUT to be a 256 entry palette
+static int KMS_HasPalette(void)
+{
+	drmModeCrtc *crtc = drmModeGetCrtc(fd, encoder->crtc_id);
+
+	gamma_size = 0;
+	if (crtc) {
+		gamma_size = crtc->gamma_size;
+		drmModeFreeCrtc(crtc);
+	}
+	return (gamma_size == 256);
+}
+
+//Returns the overlay format closest to bpp (0 if there is none) and
+//its masks for SDL_ReallocFormat
+static uint32_t KMS_ChooseFormat(int bpp, Uint32 *Rmask, Uint32 *Gmask,
+				Uint32 *Bmask, Uint32 *Amask)
+{
+	static const uint32_t order8[] = { DRM_FORMAT_C8, DRM_FORMAT_RGB565,
+	   DRM_FORMAT_XRGB8888, DRM_FORMAT_XBGR8888, DRM_FORMAT_ARGB8888,
+	   DRM_FORMAT_ABGR8888, 0 };
+	static const uint32_t order16[] = { DRM_FORMAT_RGB565, 
+	   DRM_FORMAT_XRGB8888, DRM_FORMAT_XBGR8888, DRM_FORMAT_ARGB8888,
+	   DRM_FORMAT_ABGR8888, 0 };
+	static const uint32_t order32[] = { DRM_FORMAT_XRGB8888, 
+	   DRM_FORMAT_XBGR8888, DRM_FORMAT_ARGB8888, DRM_FORMAT_ABGR8888,
+	   DRM_FORMAT_RGB565, 0 };
+	const uint32_t *order;
+	int i;
+
+	switch (bpp) {
+	   case 8:
+	      order = order8;
+	      break;
+	   case 15:
+	   case 16:
+	      order = order16;
+	      break;
+	   default:
+	      order = order32;
+	      break;
+	}
+	for (i = 0; order[i]; i++) {
+		if (!KMS_PlaneHasFormat(order[i]))
+			continue;
+		if (order[i] == DRM_FORMAT_C8 && !KMS_HasPalette())
+			continue;
+		break;
+	}
+
+	*Rmask = *Gmask = *Bmask = *Amask = 0;
+	switch (order[i]) {
+	   case DRM_FORMAT_RGB565:
+	      *Rmask = 0xF800;
+	      *Gmask = 0x07E0;
+	      *Bmask = 0x001F;
+	      break;
+	   //Con alfa por píxel el overlay se mezclaría con el fondo:
+	   //SDL_MapRGB pone el alfa a opaco si le damos la máscara.
+	   case DRM_FORMAT_ARGB8888:
+	      *Amask = 0xFF000000;
+	      /* fall through */
+	   case DRM_FORMAT_XRGB8888:
+	      *Rmask = 0x00FF0000;
+	      *Gmask = 0x0000FF00;
+	      *Bmask = 0x000000FF;
+	      break;
+	   case DRM_FORMAT_ABGR8888:
+	      *Amask = 0xFF000000;
+	      /* fall through */
+	   case DRM_FORMAT_XBGR8888:
+	      *Rmask = 0x000000FF;
+	      *Gmask = 0x0000FF00;
+	      *Bmask = 0x00FF0000;
+	      break;
+	}
+	return order[i];
+}
+
+static void KMS_DestroyBuffer(int i)
+{
+	struct kms_cached_buffer *buf = &buf_cache[i];
+
+	if (buf->bo == NULL)
+		return;
+	drmModeRmFB(fd, buf->fb_id);
+	kms_bo_unmap(buf->bo);
+	kms_bo_destroy(&buf->bo);
+	SDL_memset(buf, 0, sizeof(*buf));
+}
+
+//Returns a cache entry with a width x height buffer in the given format,
+//cleared to black, or -1.
+static int KMS_GetBuffer(int width, int height, uint32_t format)
+{
+	struct kms_cached_buffer *buf;
+	unsigned handle;
+	uint32_t handles[4] = {0}, pitches[4] = {0}, offsets[4] = {0};
+	int i, slot = -1;
+
+	for (i = 0; i < KMS_CACHE_SIZE; i++) {
+		buf = &buf_cache[i];
+		if (buf->bo && !buf->used && !buf->pinned &&
+		    buf->width == width && buf->height == height &&
+		    buf->format == format) {
+			buf->used = 1;
+			SDL_memset(buf->map, 0, buf->stride * buf->height);
+			return i;
+		}
+	}
+
+	//Un hueco libre o, si no hay, un buffer sin usar de otro tamaño
+	for (i = 0; i < KMS_CACHE_SIZE && slot < 0; i++) {
+		if (buf_cache[i].bo == NULL)
+			slot = i;
+	}
+	for (i = 0; i < KMS_CACHE_SIZE && slot < 0; i++) {
+		if (!buf_cache[i].used && !buf_cache[i].prev_used &&
+		    !buf_cache[i].pinned) {
+			KMS_DestroyBuffer(i);
+			slot = i;
+		}
+	}
+	if (slot < 0) {
+		printf ("\nERR - No quedan entradas en el cache de buffers\n");
+		return -1;
+	}
+	buf = &buf_cache[slot];
+
+	//libkms sólo crea buffers de 32 bpp: pedimos los píxeles de 32 bits
+	//justos para que quepa una línea en el formato que usamos
+	buf->bo = KMS_allocate_buffer(
+	   (width * KMS_FormatBytes(format) + 3) / 4, height, &buf->stride);
+	if (buf->bo == NULL)
+		return -1;
+	kms_bo_get_prop(buf->bo, KMS_HANDLE, &handle);
+
+	handles[0] = handle;
+	pitches[0] = buf->stride;
+	offsets[0] = 0;
+	if (drmModeAddFB2(fd, width, height, format, handles, pitches, 
+	    offsets, &buf->fb_id, 0)) {
+		printf ("\nERR - drmModeAddFB2 %dx%d: %s \n", width, height,
+		   strerror(errno));
+		kms_bo_destroy(&buf->bo);
+		SDL_memset(buf, 0, sizeof(*buf));
+		return -1;
+	}
+	if (kms_bo_map(buf->bo, (void **) &buf->map)) {
+		printf ("\nERR - No se pudo mapear el buffer %dx%d\n",
+		   width, height);
+		KMS_DestroyBuffer(slot);
+		return -1;
+	}
+	buf->width = width;
+	buf->height = height;
+	buf->format = format;
+	buf->used = 1;
+	return slot;
+}
+
+//Hands the buffers of the current mode back to the cache for the next
+//one. The buffer the overlay is showing stays pinned until the new mode
+//flips for the first time: destroying or clearing it would blank the
+//screen halfway through the switch. If something is pinned already, no
+//flip has landed since the last switch and that one is still on screen.
+static void KMS_ReleaseBuffers(void)
+{
+	int i, j, pinned = 0;
+
+	for (i = 0; i < KMS_CACHE_SIZE; i++)
+		pinned |= buf_cache[i].pinned;
+	for (i = 0; i < KMS_CACHE_SIZE; i++) {
+		buf_cache[i].prev_used = buf_cache[i].used;
+		buf_cache[i].used = 0;
+		for (j = 0; j < num_buffers && !pinned; j++) {
+			if (buf_cache[i].bo && buf_cache[i].fb_id == fb_id[j] &&
+			    buf_state[j] != KMS_BUFFER_FREE)
+				buf_cache[i].pinned = 1;
+		}
+	}
+	for (i = 0; i < num_buffers; i++) {
+		prev_fb_id[i] = fb_id[i];
+		prev_mapped_vmem[i] = mapped_vmem[i];
+	}
+	prev_crtc_fb_id = crtc_fb_id;
+}
+
+//SetVideoMode failed before switching the CRTC: the previous mode keeps
+//its buffers.
+static void KMS_RestoreBuffers(void)
+{
+	int i;
+
+	for (i = 0; i < KMS_CACHE_SIZE; i++) {
+		buf_cache[i].used = buf_cache[i].prev_used;
+		buf_cache[i].prev_used = 0;
+	}
+	for (i = 0; i < num_buffers; i++) {
+		fb_id[i] = prev_fb_id[i];
+		mapped_vmem[i] = prev_mapped_vmem[i];
+	}
+	crtc_fb_id = prev_crtc_fb_id;
+}
+
+//The new mode is set: what the previous one had may be reused or freed,
+//except for the buffer that is still pinned on screen.
+static void KMS_CommitBuffers(void)
+{
+	int i;
+
+	for (i = 0; i < KMS_CACHE_SIZE; i++)
+		buf_cache[i].prev_used = 0;
+}
+
+static void KMS_UnpinBuffers(void)
+{
+	int i;
+
+	for (i = 0; i < KMS_CACHE_SIZE; i++)
+		buf_cache[i].pinned = 0;
+}
+
+static void KMS_FlushBuffers(void)
+{
+	int i;
+
+	for (i = 0; i < KMS_CACHE_SIZE; i++)
+		KMS_DestroyBuffer(i);
+	crtc_fb_id = 0;
+}
+
 static SDL_Surface *KMS_SetVideoMode(_THIS, SDL_Surface *current,
 				int width, int height, int bpp, Uint32 flags)
 {
-	int i,ret;
+	int i, slot;
+	int crtc_index;
 	Uint32 Rmask;
 	Uint32 Gmask;
 	Uint32 Bmask;
+	Uint32 Amask;
+	SDL_Rect scale_src;
+	drmModeModeInfo mode;
+	drmModeFB *fbinfo;
 	char *surfaces_mem;
 	int surfaces_len;
 	int stride;		
-	uint32_t handles[4], pitches[4], offsets[4] = {0};
-
-	unsigned handle;
 	
 	//Se fuerzan los flags para pantalla completa. 
-	shadow_fb = 0;
+	//Sin doble buffer la aplicación dibuja en una sombra en RAM, y
+	//UpdateRects sólo copia a los buffers las zonas que cambian.
+	shadow_fb = !(flags & SDL_DOUBLEBUF);
 	current->flags |= SDL_FULLSCREEN;
-	current->flags |= SDL_HWSURFACE;
 	current->flags |= SDL_HWPALETTE;
+	current->flags &= ~(SDL_HWSURFACE | SDL_DOUBLEBUF);
 	if (flags & SDL_DOUBLEBUF)
-           current->flags |= SDL_DOUBLEBUF;
-
-	//De modinfo necesitamos estos y otros 10 vaores que completamos
-	//con la llamada a complete_mode()
-	//modinfo se usa para poner la res física (crtc), NO para crear el fb
-	modinfo.hdisplay = 1920;
-	modinfo.vdisplay = 1080;	
+           current->flags |= (SDL_HWSURFACE | SDL_DOUBLEBUF);
 
-	//Al igual que en la Rpi, usamos el modo de vídeo puesto.
-	//Sólo permito ajuste de bpp.
+	//modinfo se usa para poner la res física (crtc), NO para crear el fb.
+	//Elegimos el modo más pequeño del conector en el que cabe la aplicación.
 	printf ("\nKMS_SetVideoMode Usando modo de aplicación %d x %d %d bpp",
 		width, height, bpp);
-	
-	printf ("\nKMS_SetVideoMode Usando el modo físico %d x %d", 
-	   modinfo.hdisplay, modinfo.vdisplay);
-	
-	//Aquí completaríamos el resto de timmings del modo,
-	
-	if (complete_mode (&modinfo) == 0){
+
+	//Comprobamos que hay modo antes de tocar los buffers de la pantalla
+	//actual, así un fallo la deja como estaba.
+	if (connector->count_modes > 0 && !KMS_FindMode(width, height, &mode)) {
+	   SDL_SetError("No usable mode on this connector");
+	   return (NULL);
+	}
+
+	//Ningún flip del modo anterior puede quedar en vuelo
+	KMS_WaitPageFlip();
+
+	if (ovr) {
+		drmModeFreePlane(ovr);
+		ovr = NULL;
+	}
+	plane_resources = drmModeGetPlaneResources(fd);
+        
+	if (!plane_resources){
+                printf ("\nERROR -  No se pudo recuperar info de overlays\n");
+                KMS_VideoQuit(this);
+                return(NULL);
+        }
+	//possible_crtcs es una máscara de índices de crtc, no de ids
+	for (crtc_index = 0; crtc_index < resources->count_crtcs; crtc_index++) {
+		if (resources->crtcs[crtc_index] == encoder->crtc_id)
+			break;
+	}
+                //Buscamos un overlay que podamos conectar a nuestro crtc
+	plane_id = 0;
+        for (i = 0; i < plane_resources->count_planes; i++) {
+		ovr = drmModeGetPlane(fd, plane_resources->planes[i]);
+                if ((ovr->possible_crtcs & (1 << crtc_index)) &&
+		    KMS_IsOverlayPlane(ovr->plane_id)){
+                        plane_id = ovr->plane_id;
+			break;
+		}
+		drmModeFreePlane(ovr);
+		ovr = NULL;
+        }
+	drmModeFreePlaneResources(plane_resources);
+	plane_resources = NULL;
+        if (!plane_id) {
+                printf("\nERROR - No se pudo encontrar ningún overlay\n");
+                KMS_VideoQuit(this);
+                return (NULL);
+        }		
+	if (use_atomic && !KMS_GetPlaneProperties()) {
+		printf ("\nEl overlay no tiene propiedades atomic, usando legacy");
+		use_atomic = 0;
+	}
+
+	//Elegimos un formato que el overlay lea directamente. Si no tiene
+	//el de la aplicación devolvemos otro y SDL convierte desde una sombra.
+	pixel_format = KMS_ChooseFormat(bpp, &Rmask, &Gmask, &Bmask, &Amask);
+	if (pixel_format == 0) {
+	      SDL_SetError("The overlay supports no usable pixel format");
+	      return (NULL);
+	}
+	printf ("\nKMS_SetVideoMode Usando formato %.4s", 
+	   (char *)&pixel_format);
+
+	//Los buffers del modo anterior vuelven al cache
+	KMS_ReleaseBuffers();
+
+	if (connector->count_modes > 0) {
+	   modinfo = mode;
+	}
+	else {
+	   //Sin modos en el conector: 1080p con los timings de la tabla CEA,
+	   //completados con la llamada a complete_mode()
+	   modinfo.hdisplay = 1920;
+	   modinfo.vdisplay = 1080;	
+	   if (complete_mode (&modinfo) == 0){
 	      printf ("\nERR - No se pudo completar modo\n");
 	      KMS_VideoQuit(this);
               return (NULL);
+	   }
 	}
 	
-	//Creamos los buffers
-	switch (bpp){
-           case 8:  
-	   case 16:
-	      pixel_format =  DRM_FORMAT_RGB565;   
-	      break;
-	   case 32:
-	      pixel_format =  DRM_FORMAT_XRGB8888;     	
-      	      break;
-           default:
-	      printf ("\nERR - bpp erróneo\n");
-	      KMS_VideoQuit(this);
-              return (NULL);
-	}	
-	//MAC Creamos los dos buffers
-	for (i = 0;  i < 2; i++){
-	   bo[i] = KMS_allocate_buffer(modinfo.htotal, modinfo.vtotal, &stride);
-	   if (bo[i] == NULL){
+	printf ("\nKMS_SetVideoMode Usando el modo físico %d x %d @ %d Hz", 
+	   modinfo.hdisplay, modinfo.vdisplay, modinfo.vrefresh);
+
+	//MAC Creamos los buffers del anillo, del tamaño de la aplicación:
+	//el overlay los escala al modo físico
+	slot = KMS_GetBuffer(modinfo.hdisplay, modinfo.vdisplay, 
+	   (pixel_format == DRM_FORMAT_RGB565) ? 
+	   DRM_FORMAT_RGB565 : DRM_FORMAT_XRGB8888);
+	if (slot < 0) {
+	   printf ("\nERR - No se pudo crear el fondo del CRTC\n");
+	   KMS_RestoreBuffers();
+	   SDL_SetError("Couldn't allocate the CRTC buffer");
+	   return (NULL);
+	}
+	crtc_fb_id = buf_cache[slot].fb_id;
+	for (i = 0;  i < num_buffers; i++){
+	   slot = KMS_GetBuffer(width, height, pixel_format);
+	   if (slot < 0){
 	      printf ("\nERR - No se pudo crear buffer %d\n", i);
+	      KMS_RestoreBuffers();
+	      SDL_SetError("Couldn't allocate scanout buffer %d", i);
 	      return (NULL);
 	   }
-	   kms_bo_get_prop(bo[i], KMS_HANDLE, &handle);
-	
-	   handles[0] = handle;
-    	   pitches[0] = stride;
-   	   offsets[0] = 0;
-   	   ret = drmModeAddFB2(fd, modinfo.hdisplay, modinfo.vdisplay, 
-	      pixel_format, handles, pitches, offsets, &(fb_id[i]), 0);   
-	   if (ret) { 
-	      printf ("\nERR - drmModeAddFB2 buffer %d: %s \n",i,
-	         strerror(errno));
-             KMS_VideoQuit(this);
-	     return(NULL);
-	   }
+	   fb_id[i] = buf_cache[slot].fb_id;
+	   mapped_vmem[i] = buf_cache[slot].map;
+	   stride = buf_cache[slot].stride;
         }
            
 	//MAC Disable Graphics 2
 	//MAC Aquí sí que ponemos el nuevo videomode: 
 	//emparejamos un conector con un framebuffer.
-	i = drmModeSetCrtc(fd, encoder->crtc_id, fb_id[0], 0, 0, 
+	i = drmModeSetCrtc(fd, encoder->crtc_id, crtc_fb_id, 0, 0, 
 	&(connector->connector_id), 1, &modinfo);
 	
 	if ( i != 0 ){ 
@@ -529,38 +1140,77 @@ static SDL_Surface *KMS_SetVideoMode(_THIS, SDL_Surface *current,
 	   KMS_VideoQuit(this);
 	   return (NULL);
 	};
+	KMS_CommitBuffers();
 	
 	//MAC Esto se usa, como mínimo y que yo sepa, para DirectUpdate
 	cache_modinfo = modinfo;	
-	cache_fbinfo  = *(drmModeGetFB (fd, fb_id[0]));	
+	fbinfo = drmModeGetFB (fd, fb_id[0]);
+	if (fbinfo) {
+	   cache_fbinfo = *fbinfo;
+	   drmModeFreeFB(fbinfo);
+	}
 	
 	//MAC Esta llamada a ReallocFormat es lo que impedía ver algo...
-	Rmask = 0;
-	Gmask = 0;
-	Bmask = 0;
-	if ( ! SDL_ReallocFormat(current, bpp, Rmask, Gmask, Bmask, 0) ) {
+	if ( ! SDL_ReallocFormat(current, 8*KMS_FormatBytes(pixel_format),
+	   Rmask, Gmask, Bmask, Amask) ) {
 		return(NULL);
 	}
 	
-	current->w = modinfo.hdisplay;
-	current->h = modinfo.vdisplay;
-
-	//MAC según robclark, la memoria de un bo está alineada a pesar
-	//de la granularidad de mmpap (tamaño de página)
-	for (i = 0; i < 2; i++)
-		kms_bo_map (bo[i], (void**) &mapped_vmem[i]);
+	current->w = width;
+	current->h = height;
+
+	//Buffer 0 counts as the one on screen; with double buffering we
+	//start drawing into the next one.
+	for (i = 0; i < num_buffers; i++)
+		buf_state[i] = KMS_BUFFER_FREE;
+	buf_state[0] = KMS_BUFFER_DISPLAYED;
+	pending_page = -1;
+	last_page = 0;
+	flip_page = (current->flags & SDL_DOUBLEBUF) ? 1 : 0;
 	
-	mapped_memlen =  (stride * modinfo.vtotal); 
+	mapped_memlen =  (stride * height); 
+	physlinebytes = stride;
 	current->pitch  = stride;
-	current->pixels =  mapped_vmem[0];
+	current->pixels =  mapped_vmem[flip_page];
+
+	//La sombra tiene la misma geometría que los buffers, así que
+	//un rect está en el mismo offset en ambos. Al principio todos los
+	//buffers necesitan la pantalla completa.
+	if (shadow_mem) {
+		SDL_free(shadow_mem);
+		shadow_mem = NULL;
+	}
+	if (shadow_fb) {
+		shadow_mem = (char *)SDL_malloc(stride * height);
+		if (shadow_mem == NULL) {
+			SDL_OutOfMemory();
+			return(NULL);
+		}
+		SDL_memset(shadow_mem, 0, stride * height);
+		current->pixels = shadow_mem;
+		blitFunc = SDL_GetShadowBlit(current->format->BytesPerPixel,
+				SDL_SHADOW_COPY);
+		if (blitFunc == NULL) {
+			SDL_SetError("Using software buffer, but no blitter "
+					"function is available for %d bpp.",
+					current->format->BitsPerPixel);
+			return(NULL);
+		}
+	}
+	for (i = 0; i < num_buffers; i++) {
+		buf_numdamage[i] = 1;
+		buf_damage[i][0].x = 0;
+		buf_damage[i][0].y = 0;
+		buf_damage[i][0].w = width;
+		buf_damage[i][0].h = height;
+	}
 	
 	//phys_pixels = mapped_vmem;
 	//pixels1 = (void *)malloc(mapped_memlen);	
 	//pixels2 = (void *)malloc(mapped_memlen);	
 
 	/* Set up the information for hardware surfaces */
-	surfaces_mem = (char *)current->pixels +
-		(stride * modinfo.vtotal);
+	surfaces_mem = mapped_vmem[0] + (stride * height);
 	surfaces_len = ((mapped_memlen)-(surfaces_mem-mapped_vmem[0]));
 		
 	KMS_FreeHWSurfaces(this);
@@ -570,44 +1220,22 @@ static SDL_Surface *KMS_SetVideoMode(_THIS, SDL_Surface *current,
 	this->screen = current;
 	this->screen = NULL;
 
-	//MAC Bloque de elección de overlay empieza aquí
-	//Calculamos los offsets. En SDL_video.c se hace pero ya tras la 
-	//llamada a SetVideoMode(),así que lo tenemos que hacer nosotros antes.
-	src_offsetx = (modinfo.hdisplay - width)/2;
-	src_offsety = (modinfo.vdisplay - height)/2;
-	
-	printf ("\nsrc_offsetx = %d, src_offsety = %d", 
-	   src_offsetx, src_offsety);	
+	//El escalado lo hace el overlay: calculamos una vez por modo qué
+	//parte del buffer lee y dónde la pone. Por defecto ocupa todo el modo.
+	SDL_ComputeScaling(SDL_GetScalingPolicy(SDL_SCALE_STRETCH), 
+	   width, height, modinfo.hdisplay, modinfo.vdisplay, 
+	   &scale_src, &plane_dst);
+	printf ("\nKMS_SetVideoMode Overlay en %d,%d %d x %d", 
+	   plane_dst.x, plane_dst.y, plane_dst.w, plane_dst.h);
 	
 	//Pasamos los 4 últimos parámetros de drmModeSetPlane() 
 	//a notación 16.16 fixed point.
 	
-	src_width = (width) << 16;
-	src_height = (height) << 16;
-	src_offsetx = src_offsetx << 16;
-	src_offsety = src_offsety << 16;	
-        
-	plane_resources = drmModeGetPlaneResources(fd);
+	src_width = scale_src.w << 16;
+	src_height = scale_src.h << 16;
+	src_offsetx = scale_src.x << 16;
+	src_offsety = scale_src.y << 16;	
         
-	if (!plane_resources){
-                printf ("\nERROR -  No se pudo recuperar info de overlays\n");
-                KMS_VideoQuit(this);
-                return(NULL);
-        }
-                //Buscamos un overlay que podamos conectar a nuestro crtc
-        for (i = 0; i < plane_resources->count_planes; i++) {
-		ovr = drmModeGetPlane(fd, plane_resources->planes[i]);
-                if (ovr->possible_crtcs & encoder->crtc_id){
-                        plane_id = ovr->plane_id;
-			break;
-		}
-		drmModeFreePlane(ovr);
-        }
-        if (!plane_id) {
-                printf("\nERROR - No se pudo encontrar ningún overlay\n");
-                KMS_VideoQuit(this);
-                return (NULL);
-        }		
 	
 	/* Set the update rectangle function */
 	this->UpdateRects = KMS_DirectUpdate;
@@ -798,6 +1426,10 @@ static int KMS_LockHWSurface(_THIS, SDL_Surface *surface)
 	}
 	if ( surface == this->screen ) {
 		SDL_mutexP(hw_lock);
+		//The back buffer may still be on screen if Flip didn't wait for it
+		if ( surface->flags & SDL_DOUBLEBUF ) {
+			KMS_WaitPageFree(flip_page);
+		}
 		if ( KMS_IsSurfaceBusy(surface) ) {
 			KMS_WaitBusySurfaces(this);
 		}
@@ -825,15 +1457,158 @@ static void KMS_WaitVBL(_THIS)
 
 }
 
-void page_flip_handler(int fd, unsigned int frame,
-                  unsigned int sec, unsigned int usec, void *data)
+//Atomic path: the overlay's FB, source and destination rects go in a
+//single nonblocking commit, so the plane always shows the buffer that
+//was just flipped. Completion comes through page_flip_handler.
+static int KMS_AtomicFlip(int page, SDL_Rect *damage, int numdamage)
 {
+	drmModeAtomicReq *req;
+	struct drm_mode_rect clips[KMS_MAX_DAMAGE];
+	uint32_t blob_id = 0;
+	int i, ret;
+
+	req = drmModeAtomicAlloc();
+	if (!req)
+		return -1;
+
+	drmModeAtomicAddProperty(req, plane_id, plane_props.fb_id, fb_id[page]);
+	drmModeAtomicAddProperty(req, plane_id, plane_props.crtc_id, encoder->crtc_id);
+	drmModeAtomicAddProperty(req, plane_id, plane_props.src_x, src_offsetx);
+	drmModeAtomicAddProperty(req, plane_id, plane_props.src_y, src_offsety);
+	drmModeAtomicAddProperty(req, plane_id, plane_props.src_w, src_width);
+	drmModeAtomicAddProperty(req, plane_id, plane_props.src_h, src_height);
+	drmModeAtomicAddProperty(req, plane_id, plane_props.crtc_x, plane_dst.x);
+	drmModeAtomicAddProperty(req, plane_id, plane_props.crtc_y, plane_dst.y);
+	drmModeAtomicAddProperty(req, plane_id, plane_props.crtc_w, plane_dst.w);
+	drmModeAtomicAddProperty(req, plane_id, plane_props.crtc_h, plane_dst.h);
+
+	//Tell the driver which parts changed since the last commit. Without
+	//the property (or the rects) it assumes the whole plane did.
+	if (plane_props.damage_clips && numdamage > 0) {
+		for (i = 0; i < numdamage; i++) {
+			clips[i].x1 = damage[i].x;
+			clips[i].y1 = damage[i].y;
+			clips[i].x2 = damage[i].x + damage[i].w;
+			clips[i].y2 = damage[i].y + damage[i].h;
+		}
+		if (drmModeCreatePropertyBlob(fd, clips, 
+		    numdamage * sizeof(clips[0]), &blob_id) == 0) {
+			drmModeAtomicAddProperty(req, plane_id, 
+			   plane_props.damage_clips, blob_id);
+		}
+	}
 
-	int *waiting_for_vblank = data;
-	*waiting_for_vblank = 0;	
+	ret = drmModeAtomicCommit(fd, req, 
+	   DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, (void *)(long)page);
+	drmModeAtomicFree(req);
+	//The commit holds its own reference to the blob
+	if (blob_id)
+		drmModeDestroyPropertyBlob(fd, blob_id);
+	return ret;
+}
+
+//Legacy path: the overlay plane gets the new buffer and the CRTC flips
+//to its (unchanged) background, which gives us the vblank event.
+static int KMS_LegacyFlip(int page, SDL_Rect *damage, int numdamage)
+{
+	drmModeClip clips[KMS_MAX_DAMAGE];
+	int i, ret;
 
+	drmModeSetPlane(fd, plane_id, encoder->crtc_id, fb_id[page],
+	   0, plane_dst.x, plane_dst.y, plane_dst.w, plane_dst.h, src_offsetx, 
+	   src_offsety, src_width, src_height);
+
+	ret = drmModePageFlip (fd, encoder->crtc_id, crtc_fb_id,
+	   DRM_MODE_PAGE_FLIP_EVENT, (void *)(long)page);
+
+	//Drivers that need explicit flushing get the damaged rects; the 
+	//rest return an error that we can ignore.
+	if (ret == 0 && numdamage > 0) {
+		for (i = 0; i < numdamage; i++) {
+			clips[i].x1 = damage[i].x;
+			clips[i].y1 = damage[i].y;
+			clips[i].x2 = damage[i].x + damage[i].w;
+			clips[i].y2 = damage[i].y + damage[i].h;
+		}
+		drmModeDirtyFB(fd, fb_id[page], clips, numdamage);
+	}
+	return ret;
+}
 
+//Puts a buffer on screen. The page number travels with the flip event
+//as user data. damage lists what changed since the last flip (NULL for
+//everything).
+static void KMS_SubmitPage(int page, SDL_Rect *damage, int numdamage)
+{
+	int ret = -1;
+
+	if (use_atomic) {
+		ret = KMS_AtomicFlip(page, damage, numdamage);
+		if (ret != 0) {
+			printf ("\nERR - atomic commit: %s, usando legacy\n",
+			   strerror(errno));
+			use_atomic = 0;
+		}
+	}
+	if (!use_atomic)
+		ret = KMS_LegacyFlip(page, damage, numdamage);
+
+	if (ret != 0) {
+		//No event will come for this one: it stays where it was
+		buf_state[page] = (page == last_page) ? 
+			KMS_BUFFER_DISPLAYED : KMS_BUFFER_FREE;
+		return;
+	}
+	buf_state[page] = KMS_BUFFER_PENDING;
+	pending_page = page;
+	last_page = page;
+}
+
+//Returns the oldest buffer waiting for the CRTC, or -1.
+static int KMS_NextQueuedPage(void)
+{
+	int i, page = -1;
+
+	for (i = 0; i < num_buffers; i++) {
+		if (buf_state[i] == KMS_BUFFER_QUEUED &&
+		   (page < 0 || (int)(buf_seq[i] - buf_seq[page]) < 0)) {
+			page = i;
+		}
+	}
+	return page;
+}
+
+void page_flip_handler(int fd, unsigned int frame,
+                  unsigned int sec, unsigned int usec, void *data)
+{
+	int page = (int)(long)data;
+	Uint32 when;
+	int i;
+
+	//The buffer that was on screen until now can be drawn into again
+	for (i = 0; i < num_buffers; i++) {
+		if (i != page && buf_state[i] == KMS_BUFFER_DISPLAYED)
+			buf_state[i] = KMS_BUFFER_FREE;
+	}
+	buf_state[page] = KMS_BUFFER_DISPLAYED;
+	pending_page = -1;
+	//The overlay reads from the new mode's buffers now
+	KMS_UnpinBuffers();
+
+	//The event timestamp is CLOCK_MONOTONIC, same as SDL_FrameStatsNow()
+	//when that one is built on clock_gettime(); otherwise it's ticks.
+#if HAVE_CLOCK_GETTIME
+	when = (Uint32)sec * 1000000 + usec;
+#else
+	when = SDL_FrameStatsNow();
+#endif
+	SDL_FrameStatsFlip(when, when - queue_time[page], frame);
 
+	//Only one flip can be pending on the CRTC, so the next queued buffer
+	//goes out now that this one has landed.
+	page = KMS_NextQueuedPage();
+	if (page >= 0)
+		KMS_SubmitPage(page, NULL, 0);
 }
 
 
@@ -842,98 +1617,194 @@ static void KMS_WaitIdle(_THIS)
 	return;
 }
 
+//Reads the DRM events that are ready, or blocks until the next one arrives
+//if block is set. drmHandleEvent() runs page_flip_handler for us.
+static void KMS_HandleFlipEvents(int block)
+{
+	struct timeval tv = { 0, 0 };
+	Uint32 start = SDL_FrameStatsNow();
+	int ready;
+
+	FD_ZERO(&fds);
+	FD_SET(fd, &fds);
+	ready = select(fd + 1, &fds, NULL, NULL, block ? NULL : &tv);
+	if (block)
+		SDL_FrameStatsWait(SDL_FrameStatsNow() - start);
+	if (ready > 0) {
+		drmHandleEvent(fd, &evctx);
+	}
+	else if (ready < 0 && errno != EINTR) {
+		//No event is ever going to come (fd gone, DRM master lost...):
+		//give up on the flips in flight so nobody waits for them forever.
+		int i;
+		printf ("\nERR - esperando flips: %s\n", strerror(errno));
+		for (i = 0; i < num_buffers; i++) {
+			if (buf_state[i] == KMS_BUFFER_PENDING ||
+			    buf_state[i] == KMS_BUFFER_QUEUED)
+				buf_state[i] = KMS_BUFFER_FREE;
+		}
+		pending_page = -1;
+	}
+}
+
+//PumpEvents: además de la entrada, recoge los flips terminados, que si la
+//app duerme en SDL_WaitEvent() nadie más lo haría. Con el hilo de eventos
+//no: los flips son cosa del hilo que dibuja.
+static void KMS_PumpAll(_THIS)
+{
+	if (SDL_EventThreadID() == 0)
+		KMS_HandleFlipEvents(0);
+	KMS_PumpEvents(this);
+}
+
+//Blocks until no flip is in flight on the CRTC.
+static void KMS_WaitPageFlip(void)
+{
+	while (pending_page >= 0)
+		KMS_HandleFlipEvents(1);
+}
+
+//Blocks until we are allowed to draw into the given buffer. If no flip
+//is in flight nothing can free it, so we don't wait at all.
+static void KMS_WaitPageFree(int page)
+{
+	while (buf_state[page] != KMS_BUFFER_FREE && pending_page >= 0)
+		KMS_HandleFlipEvents(1);
+}
+
+//Picks the buffer to draw the next frame into: a free one if there is
+//any, otherwise the one that the pending flip will release.
+static int KMS_NextDrawPage(void)
+{
+	int i;
+
+	for (i = 0; i < num_buffers; i++) {
+		if (buf_state[i] == KMS_BUFFER_FREE)
+			return i;
+	}
+	for (i = 0; i < num_buffers; i++) {
+		if (buf_state[i] == KMS_BUFFER_DISPLAYED)
+			return i;
+	}
+	return flip_page;
+}
+
 static int KMS_FlipHWSurface(_THIS, SDL_Surface *surface)
 {
 	if ( switched_away ) {
 		return -2; // no hardware access
 	}
 
-	waiting_for_vblank = 1;
-	
-	//MAC vbl wait stuff
+	//If the app didn't lock the surface, make sure we weren't drawing
+	//over a buffer that is still on screen.
+	KMS_WaitPageFree(flip_page);
 
-        memset(&evctx, 0, sizeof evctx);
-        evctx.version = DRM_EVENT_CONTEXT_VERSION;
-        evctx.vblank_handler = NULL;
-        evctx.page_flip_handler = page_flip_handler;
+	//Pick up the flips that completed since the last call and queue this
+	//buffer behind them. It goes out right away if the CRTC is idle.
+	KMS_HandleFlipEvents(0);
+	buf_state[flip_page] = KMS_BUFFER_QUEUED;
+	buf_seq[flip_page] = queue_seq++;
+	queue_time[flip_page] = SDL_FrameStatsNow();
+	if (pending_page < 0)
+		KMS_SubmitPage(KMS_NextQueuedPage(), NULL, 0);
 
-        FD_ZERO(&fds);
-        FD_SET(0, &fds);
-        FD_SET(fd, &fds);
-	
-	//MAC Volcaríamos el frame completo al buffer en GPU que tocase
-	//memcpy (flip_address[flip_page], surface->pixels, mapped_memlen);
-	
-	//Lo de pasarle !flip_page es un fix temporal hasta atomic pageflip. 
-	//Ver detalles en cuaderno.
-	//printf ("\ncrtc->mode.hdisplay = %d, crtc->mode.vdisplay = %d",
-	//crtc->mode.hdisplay, crtc->mode.vdisplay);
-	drmModeSetPlane(fd, plane_id, encoder->crtc_id,fb_id[!flip_page],
-	   0,0,0,modinfo.hdisplay, modinfo.vdisplay, src_offsetx, 
-	   src_offsety, src_width, src_height);
-
-	drmModePageFlip (fd, encoder->crtc_id, fb_id[flip_page],
-	   DRM_MODE_PAGE_FLIP_EVENT,&waiting_for_vblank);
 	//Así que esperamos a que se de el cambiazo 
-	//(durante el período de vsync) para seguir
-	while (waiting_for_vblank){        
-		select(fd + 1, &fds, NULL, NULL, 0);
-		drmHandleEvent(fd, &evctx);
-		//MAC Esto es imprescindible para identificar de qué evento se 
-		//trata y si es el evento que nosostros esperamos ("page_flip 
-		//completado") ejecutamos la función de callback sólo si se 
-		//trata de ese evento.Si es otro evento,nos quedamos en el loop.
+	//(durante el período de vsync) para seguir, salvo en modo asíncrono.
+	if (!async_flip) {
+		while (buf_state[flip_page] == KMS_BUFFER_QUEUED || 
+		       buf_state[flip_page] == KMS_BUFFER_PENDING) {
+			KMS_HandleFlipEvents(1);
+		}
 	}
-			
-
 	
-	flip_page = !flip_page;
+	//In async mode this buffer may still be busy: Lock waits for it
+	flip_page = KMS_NextDrawPage();
 	surface->pixels = mapped_vmem[flip_page];
 	
 	return (0);
 }
 
-#define BLOCKSIZE_W 32
-#define BLOCKSIZE_H 32
+//Adds a rect to the list of areas a buffer is missing
+static void KMS_AddDamage(int page, SDL_Rect *rect)
+{
+	SDL_Rect *damage = buf_damage[page];
+	int i, x1, y1, x2, y2;
+
+	if (buf_numdamage[page] < KMS_MAX_DAMAGE) {
+		damage[buf_numdamage[page]++] = *rect;
+		return;
+	}
+
+	//No room left: merge everything into one bounding box
+	x1 = rect->x;
+	y1 = rect->y;
+	x2 = rect->x + rect->w;
+	y2 = rect->y + rect->h;
+	for (i = 0; i < buf_numdamage[page]; i++) {
+		x1 = min(x1, damage[i].x);
+		y1 = min(y1, damage[i].y);
+		if (damage[i].x + damage[i].w > x2)
+			x2 = damage[i].x + damage[i].w;
+		if (damage[i].y + damage[i].h > y2)
+			y2 = damage[i].y + damage[i].h;
+	}
+	damage[0].x = x1;
+	damage[0].y = y1;
+	damage[0].w = x2 - x1;
+	damage[0].h = y2 - y1;
+	buf_numdamage[page] = 1;
+}
+
+//Brings a buffer up to date with the shadow, copying only what it misses
+static void KMS_CopyDamage(_THIS, int page)
+{
+	int bytes_per_pixel = this->screen->format->BytesPerPixel;
+	int i;
+	char *src_start;
+	char *dst_start;
+	Uint32 start = SDL_FrameStatsNow();
+
+	for (i = 0; i < buf_numdamage[page]; i++) {
+		SDL_Rect *rect = &buf_damage[page][i];
+
+		src_start = shadow_mem + rect->y * physlinebytes + 
+			rect->x * bytes_per_pixel;
+		dst_start = mapped_vmem[page] + rect->y * physlinebytes + 
+			rect->x * bytes_per_pixel;
+		blitFunc((Uint8 *) src_start,
+				1,
+				physlinebytes / bytes_per_pixel,
+				(Uint8 *) dst_start,
+				physlinebytes,
+				rect->w,
+				rect->h);
+	}
+	buf_numdamage[page] = 0;
+	SDL_FrameStatsCopy(SDL_FrameStatsNow() - start);
+}
 
 static void KMS_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
 {	
-	
-	int i;	
-	int width = cache_modinfo.hdisplay;
-	int height = cache_modinfo.vdisplay;
-	int bytes_per_pixel = (cache_fbinfo.bpp + 7) / 8;
-		
-	
-	/*MAC Empieza simulación de doble buffer*/
-	drmModeSetPlane(fd, plane_id, encoder->crtc_id,fb_id[flip_page],
-	   0,0,0, modinfo.hdisplay, modinfo.vdisplay, src_offsetx, 
-	   src_offsety, src_width, src_height);
-	drmModePageFlip (fd, encoder->crtc_id, fb_id[flip_page],
-	   DRM_MODE_PAGE_FLIP_EVENT,&waiting_for_vblank);
-	return;	
-	/*Acaba simulación de doble buffer*/
+	int i, page;
+	int width = cache_fbinfo.width;
+	int height = cache_fbinfo.height;
+	SDL_Rect damage[KMS_MAX_DAMAGE];
+	int numdamage = 0;
+	int toomany = 0;
 	
 	if (!shadow_fb) {
-	   /* The application is already updating the visible video memory */
-		return;
-	}
-	
-	if (cache_fbinfo.bpp != 16) {
-		SDL_SetError("Shadow copy only implemented for 16 bpp");
+		//Double buffered: the app draws into a buffer that isn't on
+		//screen and presents it with SDL_Flip(), so there's nothing
+		//to do here. Resubmitting that buffer would show it half drawn.
 		return;
 	}
+
 	for (i = 0; i < numrects; i++) {
 		int x1, y1, x2, y2;
-		int scr_x1, scr_y1, scr_x2, scr_y2;
-		int sha_x1, sha_y1;
-		int shadow_right_delta;  /* Address change when moving right in dest */
-		int shadow_down_delta;   /* Address change when moving down in dest */
-		char *src_start;
-		char *dst_start;
-
-		x1 = rects[i].x; 
-		y1 = rects[i].y;
+
+		//Los rects vienen en coordenadas de la aplicación
+		x1 = rects[i].x + this->offset_x; 
+		y1 = rects[i].y + this->offset_y;
 		x2 = x1 + rects[i].w; 
 		y2 = y1 + rects[i].h;
 
@@ -961,25 +1832,56 @@ static void KMS_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
 			continue;
 		}
 
-		sha_x1 = scr_x1 = x1;
-		sha_y1 = scr_y1 = y1;
-		scr_x2 = x2;
-		scr_y2 = y2;
-		shadow_right_delta = 1;
-		shadow_down_delta = width;
+		if (numdamage == KMS_MAX_DAMAGE) {
+			//Too many to report to the driver: send no clips at all
+			toomany = 1;
+			numdamage--;
+		}
 
-		src_start = shadow_mem +
-			(sha_y1 * width + sha_x1) * bytes_per_pixel;
-		dst_start = mapped_vmem[0] + mapped_offset + scr_y1 * physlinebytes + 
-			scr_x1 * bytes_per_pixel;
+		//Every buffer is missing this area now, including the ones on
+		//screen: they'll catch up the next time we draw into them.
+		damage[numdamage].x = x1;
+		damage[numdamage].y = y1;
+		damage[numdamage].w = x2 - x1;
+		damage[numdamage].h = y2 - y1;
+		for (page = 0; page < num_buffers; page++)
+			KMS_AddDamage(page, &damage[numdamage]);
+		numdamage++;
+	}
+	if (numdamage == 0) {
+		return;
+	}
+	if (toomany) {
+		numdamage = 0;
+	}
 
-		blitFunc((Uint8 *) src_start,
-				shadow_right_delta, 
-				shadow_down_delta, 
-				(Uint8 *) dst_start,
-				physlinebytes,
-				scr_x2 - scr_x1,
-				scr_y2 - scr_y1);
+	//Pick a buffer that isn't on screen nor waiting to get there
+	KMS_HandleFlipEvents(0);
+	for (;;) {
+		for (page = 0; page < num_buffers; page++) {
+			if (buf_state[page] == KMS_BUFFER_FREE)
+				break;
+		}
+		if (page < num_buffers || pending_page < 0)
+			break;
+		KMS_HandleFlipEvents(1);
+	}
+	if (page == num_buffers) {
+		return;
+	}
+
+	KMS_CopyDamage(this, page);
+
+	//Goes out now if the CRTC is idle, or behind the pending flip
+	buf_state[page] = KMS_BUFFER_QUEUED;
+	buf_seq[page] = queue_seq++;
+	queue_time[page] = SDL_FrameStatsNow();
+	if (pending_page < 0) {
+		int next = KMS_NextQueuedPage();
+		if (next == page)
+			KMS_SubmitPage(page, damage, numdamage);
+		else
+			KMS_SubmitPage(next, NULL, 0);
 	}
 }
 
@@ -989,6 +1891,26 @@ static void KMS_DirectUpdate(_THIS, int numrects, SDL_Rect *rects)
 
 static int KMS_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
 {
+	int i;
+
+	//Sólo en C8 la paleta es nuestra; en los demás formatos SDL convierte
+	if (pixel_format != DRM_FORMAT_C8)
+		return (1);
+
+	if (!gamma_saved) {
+		gamma_saved = (drmModeCrtcGetGamma(fd, encoder->crtc_id, 256,
+		   saved_r, saved_g, saved_b) == 0);
+	}
+	for (i = 0; i < ncolors && firstcolor + i < 256; i++) {
+		pal_r[firstcolor + i] = colors[i].r << 8 | colors[i].r;
+		pal_g[firstcolor + i] = colors[i].g << 8 | colors[i].g;
+		pal_b[firstcolor + i] = colors[i].b << 8 | colors[i].b;
+	}
+	if (drmModeCrtcSetGamma(fd, encoder->crtc_id, 256, 
+	    pal_r, pal_g, pal_b)) {
+		printf ("\nERR - drmModeCrtcSetGamma: %s\n", strerror(errno));
+		return (0);
+	}
 	return (1);
 }
 
@@ -1002,8 +1924,8 @@ static void KMS_VideoQuit(_THIS)
 	   const char *dontClearPixels = SDL_getenv("SDL_FBCON_DONT_CLEAR");
 	      //No tenemos que limpiar el framebuffer: evitamos mostrar el
 	      //buffer en que estamos dibujando.
-	      if ( dontClearPixels && flip_page == 0 ) {
-	         SDL_memcpy(mapped_vmem[0], mapped_vmem[1], 
+	      if ( dontClearPixels && last_page != 0 ) {
+	         SDL_memcpy(mapped_vmem[0], mapped_vmem[last_page], 
 		 this->screen->pitch * this->screen->h);
 	      }
 	      //En este caso sí tenemos que limpiar el framebuffer	
@@ -1046,13 +1968,26 @@ static void KMS_VideoQuit(_THIS)
 	/* Clean up the memory bucket list */
 	KMS_FreeHWSurfaces(this);
 
+	if ( shadow_mem ) {
+		SDL_free(shadow_mem);
+		shadow_mem = NULL;
+	}
+
 	/* Close console and input file descriptors */
 	if ( fd > 0 ) {
-		/* Unmap the video framebuffer and I/O registers */
-		for (i = 0; i < 2; i++)	{
-		   munmap(mapped_vmem[i], mapped_memlen);
-		   mapped_vmem[i] = NULL;
+		/* Don't free the buffers under a flip still in flight */
+		KMS_WaitPageFlip();
+
+		if ( gamma_saved ) {
+		   drmModeCrtcSetGamma(fd, encoder->crtc_id, 256,
+		      saved_r, saved_g, saved_b);
+		   gamma_saved = 0;
 		}
+
+		/* Unmap and free the scanout buffers */
+		KMS_FlushBuffers();
+		for (i = 0; i < num_buffers; i++)
+		   mapped_vmem[i] = NULL;
 		if ( mapped_io ) {
 			munmap(mapped_io, mapped_iolen);
 			mapped_io = NULL;
@@ -1064,11 +1999,9 @@ static void KMS_VideoQuit(_THIS)
 		for (i = 0; i < resources->count_fbs; ++i)
 		   drmModeRmFB(fd, resources->fbs[i]);	
 		
-		for ( i = 0; i < 2; i++ ){
-		   if (bo[i] != NULL){ 
-	   	      kms_bo_unmap(bo[i]);
-	   	      kms_bo_destroy(&bo[i]);
-		   }
+		if (ovr) {
+		   drmModeFreePlane(ovr);
+		   ovr = NULL;
 		}
 		kms_destroy(&kms);	
 		
@@ -1077,10 +2010,17 @@ static void KMS_VideoQuit(_THIS)
    		drmModeFreeResources(resources);
 		
 		/* We're all done with the framebuffer */
+		SDL_DelEventFD(fd, 0);
 		close(fd);
 		fd = -1;
 	}
 	KMS_CloseMouse(this);
+#if SDL_INPUT_LINUXEV
+	if ( use_evdev ) {
+		SDL_EvdevQuit();
+		use_evdev = 0;
+	}
+#endif
 	KMS_CloseKeyboard(this);
 	exit (0);
 }
@@ -138,6 +138,11 @@ int TestCPUInfo(SDL_bool verbose)
 		printf("SSE %s\n", SDL_HasSSE() ? "detected" : "not detected");
 		printf("SSE2 %s\n", SDL_HasSSE2() ? "detected" : "not detected");
 		printf("AltiVec %s\n", SDL_HasAltiVec() ? "detected" : "not detected");
+		printf("VFP %s\n", SDL_HasVFP() ? "detected" : "not detected");
+		printf("NEON %s\n", SDL_HasNEON() ? "detected" : "not detected");
+		printf("ARMv8 %s\n", SDL_HasARMv8() ? "detected" : "not detected");
+		printf("CPU count: %d\n", SDL_GetCPUCount());
+		printf("Cache line size: %d\n", SDL_GetCPUCacheLineSize());
 	}
 	return(0);
 }